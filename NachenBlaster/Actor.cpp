@@ -1,28 +1,48 @@
 #include "Actor.h"
 #include "StudentWorld.h"
 #include <iostream>
-#include <random>
 using namespace std;
 
+//ActorBucket Implementation
+void ActorBucket::moveSlot(size_t from, size_t to)
+{
+    actors[to] = actors[from];
+    x[to] = x[from];
+    y[to] = y[from];
+    radius[to] = radius[from];
+    deltaX[to] = deltaX[from];
+    deltaY[to] = deltaY[from];
+    speed[to] = speed[from];
+    hitPoints[to] = hitPoints[from];
+    dead[to] = dead[from];
+    actors[to]->setSlot(static_cast<int>(to));
+}
+
 //Actor Implementation
-Actor::Actor(StudentWorld* w, double startX, double startY, int imageID, double damageAmt, double deltaX, double deltaY, double distance, int imageDir, double size, int depth):GraphObject(imageID, startX, startY, imageDir, size, depth)
+Actor::Actor(StudentWorld* w, int kind, double startX, double startY, int imageID, double damageAmt, double deltaX, double deltaY, double distance, int imageDir, double size, int depth):GraphObject(w->graphObjects(), imageID, startX, startY, imageDir, size, depth)
 {
     m_world = w;
-    m_isDead = false;
+    m_kind = kind;
+    m_gridCell = -1;
     m_damageAmt = damageAmt;
-    m_deltaX = deltaX;
-    m_deltaY = deltaY;
-    m_distance = distance;
+    m_bucket = &w->actorsOfKind(kind);
+    m_slot = m_bucket->add(this, startX, startY, GraphObject::getRadius(), deltaX, deltaY, distance);
 }
 
-bool Actor::isDead() const
+void Actor::setSize(double size)
 {
-    return m_isDead;
+    GraphObject::setSize(size);
+    m_bucket->radius[m_slot] = GraphObject::getRadius();
 }
 
 bool Actor::isAlien() const
 {
-    return false;
+    return m_kind == KIND_ALIEN;
+}
+
+int Actor::kind() const
+{
+    return m_kind;
 }
 
 StudentWorld* Actor::world() const
@@ -35,52 +55,90 @@ double Actor::damageAmt() const
     return m_damageAmt;
 }
 
-double Actor::distance() const
-{
-    return m_distance;
-}
-
-double Actor::deltaX() const
-{
-    return m_deltaX;
-}
-
-double Actor::deltaY() const
-{
-    return m_deltaY;
-}
-
 void Actor::setDeltaY(double dy)
 {
     if (isAlien()) {  //this is to ensure that only aliens can use this function, as it is the only class that ever needs to
-        m_deltaY = dy;
+        m_bucket->deltaY[m_slot] = dy;
     }
 }
 
 void Actor::setDistance(double d)
 {
     if (isAlien()) {  //allow aliens to change travel distance per tick, if necessary
-        m_distance = d;
+        m_bucket->speed[m_slot] = d;
     }
 }
 
 void Actor::setDead()
 {
-    m_isDead = true;
+    m_bucket->dead[m_slot] = 1;
 }
 
 void Actor::moveTo(double x, double y)
 {
     if ((getX() >= 0 && getX() < VIEW_WIDTH && getY() >= 0 && getY() < VIEW_HEIGHT) || (isAlien() && getX() >= 0 && getX() < VIEW_WIDTH)) { //aliens are allowed to be out of bounds vertically for a bit before they correct their flight path
         GraphObject::moveTo(x, y);
+        m_bucket->x[m_slot] = x;
+        m_bucket->y[m_slot] = y;
+        if (m_gridCell >= 0) {
+            world()->actorMoved(this);  //keep the world's collision grid up to date
+        }
     }
     else {
         setDead();
     }
 }
 
+int Actor::gridCell() const
+{
+    return m_gridCell;
+}
+
+void Actor::setGridCell(int cell)
+{
+    m_gridCell = cell;
+}
+
+int Actor::slot() const
+{
+    return m_slot;
+}
+
+void Actor::setSlot(int slot)
+{
+    m_slot = slot;
+}
+
+ActorBucket* Actor::bucket() const
+{
+    return m_bucket;
+}
+
+void Actor::save(ActorRecord& r) const
+{
+    r.imageID = getImageID();
+    r.direction = getDirection();
+    r.dead = isDead();
+    r.x = getX();
+    r.y = getY();
+    r.size = getSize();
+    r.deltaX = deltaX();
+    r.deltaY = deltaY();
+    r.distance = distance();
+}
+
+void Actor::restore(const ActorRecord& r)
+{
+    setDirection(r.direction);
+    setSize(r.size);
+    m_bucket->dead[m_slot] = r.dead != 0;
+    m_bucket->deltaX[m_slot] = r.deltaX;
+    m_bucket->deltaY[m_slot] = r.deltaY;
+    m_bucket->speed[m_slot] = r.distance;
+}
+
 //Star Implementation
-Star::Star(StudentWorld* w, double startX, double startY, double size):Actor(w, startX, startY, IID_STAR, 0.0, -1.0, 0.0, 1.0, 0, size, 3)
+Star::Star(StudentWorld* w, double startX, double startY, double size):Actor(w, KIND_STAR, startX, startY, IID_STAR, 0.0, -1.0, 0.0, 1.0, 0, size, 3)
 {
     
 }
@@ -94,8 +152,27 @@ void Star::doSomething()
     moveTo(x + (dx * d), y);
 }
 
+void Star::moveAll(ActorBucket& stars)
+{
+    for (size_t i = 0; i < stars.size(); i++) {
+        if (stars.dead[i]) {
+            continue;
+        }
+        double x = stars.x[i];
+        double y = stars.y[i];
+        if (x >= 0 && x < VIEW_WIDTH && y >= 0 && y < VIEW_HEIGHT) {  //same check as Actor::moveTo; stars are never in the grid
+            x += stars.deltaX[i] * stars.speed[i];
+            stars.x[i] = x;
+            stars.actors[i]->GraphObject::moveTo(x, y);
+        }
+        else {
+            stars.dead[i] = 1;
+        }
+    }
+}
+
 //Explosion Implementation
-Explosion::Explosion(StudentWorld* w, double startX, double startY):Actor(w, startX, startY, IID_EXPLOSION, 0.0, 0.0, 0.0, 0.0, 0, 1.0, 0)
+Explosion::Explosion(StudentWorld* w, double startX, double startY):Actor(w, KIND_EXPLOSION, startX, startY, IID_EXPLOSION, 0.0, 0.0, 0.0, 0.0, 0, 1.0, 0)
 {
     m_cycle = 0;
 }
@@ -112,27 +189,40 @@ void Explosion::doSomething()
     }
 }
 
+void Explosion::save(ActorRecord& r) const
+{
+    Actor::save(r);
+    r.cycle = m_cycle;
+}
+
+void Explosion::restore(const ActorRecord& r)
+{
+    Actor::restore(r);
+    m_cycle = r.cycle;
+}
+
 //DamageableObject Implementation
-DamageableObject::DamageableObject(StudentWorld* w, double startX, double startY, int imageID, int startDir, double size, int depth, double hitPoints, double damageAmt, double deltaX, double deltaY, double distance):Actor(w, startX, startY, imageID, damageAmt, deltaX, deltaY, distance, startDir, size, depth)
+DamageableObject::DamageableObject(StudentWorld* w, int kind, double startX, double startY, int imageID, int startDir, double size, int depth, double hitPoints, double damageAmt, double deltaX, double deltaY, double distance):Actor(w, kind, startX, startY, imageID, damageAmt, deltaX, deltaY, distance, startDir, size, depth)
 {
-    m_hitPoints = hitPoints;
+    bucket()->hitPoints[slot()] = hitPoints;
 }
 
 double DamageableObject::hitPoints() const
 {
-    return m_hitPoints;
+    return bucket()->hitPoints[slot()];
 }
 
 void DamageableObject::increaseHitPoints(double amt)
 {
-    m_hitPoints += amt;  //when player obtains repair kit and to faciliate setting up alien's initial health per round
+    bucket()->hitPoints[slot()] += amt;  //when player obtains repair kit and to faciliate setting up alien's initial health per round
 }
 
 void DamageableObject::sufferDamage(double amt, int cause)
 {
     if ((cause == HIT_BY_PROJECTILE) || (!isAlien() && cause == HIT_BY_SHIP)) { //player hit alien or either player or alien got hit by projectile
-        m_hitPoints -= amt;
-        if (m_hitPoints <= 0) {
+        double& hp = bucket()->hitPoints[slot()];
+        hp -= amt;
+        if (hp <= 0) {
             setDead();
             if (!isAlien()) {
                 world()->decLives(); //player loses a life
@@ -144,8 +234,20 @@ void DamageableObject::sufferDamage(double amt, int cause)
     }
 }
 
+void DamageableObject::save(ActorRecord& r) const
+{
+    Actor::save(r);
+    r.hitPoints = hitPoints();
+}
+
+void DamageableObject::restore(const ActorRecord& r)
+{
+    Actor::restore(r);
+    bucket()->hitPoints[slot()] = r.hitPoints;
+}
+
 //Player Implementation
-Player::Player(StudentWorld* w): DamageableObject(w, 0.0, 128.0, IID_NACHENBLASTER, 0, 1.0, 0, 50.0, 0.0, 1.0, 1.0, 6.0)
+Player::Player(StudentWorld* w): DamageableObject(w, KIND_PLAYER, 0.0, 128.0, IID_NACHENBLASTER, 0, 1.0, 0, 50.0, 0.0, 1.0, 1.0, 6.0)
 {
     m_cabbagePower = 30;
     m_torpedos = 0;
@@ -154,48 +256,48 @@ Player::Player(StudentWorld* w): DamageableObject(w, 0.0, 128.0, IID_NACHENBLAST
 void Player::doSomething()
 {
     if (!isDead()) {
-        int key;
+        const TickInput& input = world()->drainInput();
+        //movement and cabbages go on for as long as their keys are held,
+        //but each press of tab fires only one torpedo
+        unsigned int keys = input.heldKeys;
+        bool fireTorpedo = false;
+        for (int i = 0; i < input.numEvents; i++) {
+            keys |= heldKeyBit(input.events[i].key);
+            if (input.events[i].key == KEY_PRESS_TAB) {
+                fireTorpedo = true;
+            }
+        }
         double x = getX();
         double y = getY();
-        if (world()->getKey(key)) { //user pressed key
-            switch (key) {
-                case KEY_PRESS_UP:  //try to move up
-                    if (y + 6.0 < VIEW_HEIGHT) {
-                        moveTo(x, y + 6.0);
-                    }
-                    break;
-                case KEY_PRESS_RIGHT:  //try to move right
-                    if (x + 6.0 < VIEW_WIDTH) {
-                        moveTo(x + 6.0, y);
-                    }
-                    break;
-                case KEY_PRESS_DOWN:  //try to move down
-                    if (y - 6.0 >= 0) {
-                        moveTo(x, y - 6.0);
-                    }
-                    break;
-                case KEY_PRESS_LEFT:   //try to move left
-                    if (x - 6.0 >= 0) {
-                        moveTo(x - 6.0, y);
-                    }
-                    break;
-                case KEY_PRESS_SPACE:  //shoot cabbages, if enough fire power
-                    if (m_cabbagePower >= 5) {
-                        world()->addActor(new Cabbage(world(), getX() + 12.0, getY()));
-                        world()->playSound(SOUND_PLAYER_SHOOT);
-                        m_cabbagePower -= 5;
-                    }
-                    break;
-                case KEY_PRESS_TAB: //fire torpedos, if player has any
-                    if (m_torpedos > 0) {
-                        world()->addActor(new PlayerLaunchedTorpedo(world(), getX() + 12.0, getY()));
-                        world()->playSound(SOUND_TORPEDO);
-                        m_torpedos -= 1;
-                    }
-                    break;
-                default: //invalid key
-                    break;
-            }
+        bool moved = false;
+        if ((keys & HELD_UP) && y + 6.0 < VIEW_HEIGHT) { //try to move up
+            y += 6.0;
+            moved = true;
+        }
+        if ((keys & HELD_RIGHT) && x + 6.0 < VIEW_WIDTH) { //try to move right
+            x += 6.0;
+            moved = true;
+        }
+        if ((keys & HELD_DOWN) && y - 6.0 >= 0) { //try to move down
+            y -= 6.0;
+            moved = true;
+        }
+        if ((keys & HELD_LEFT) && x - 6.0 >= 0) { //try to move left
+            x -= 6.0;
+            moved = true;
+        }
+        if (moved) {
+            moveTo(x, y);
+        }
+        if ((keys & HELD_SPACE) && m_cabbagePower >= 5) { //shoot cabbages, if enough fire power
+            world()->spawnActor<Cabbage>(getX() + 12.0, getY());
+            world()->playSound(SOUND_PLAYER_SHOOT);
+            m_cabbagePower -= 5;
+        }
+        if (fireTorpedo && m_torpedos > 0) { //fire torpedos, if player has any
+            world()->spawnActor<PlayerLaunchedTorpedo>(getX() + 12.0, getY());
+            world()->playSound(SOUND_TORPEDO);
+            m_torpedos -= 1;
         }
         //Collisions handled in alien and projectile classes classes.
         if (m_cabbagePower < 30) { //restore cabbage power, no matter what player does
@@ -224,19 +326,28 @@ int Player::numTorpedoes() const
     return m_torpedos;
 }
 
+void Player::save(ActorRecord& r) const
+{
+    DamageableObject::save(r);
+    r.cabbagePower = m_cabbagePower;
+    r.torpedoes = m_torpedos;
+}
+
+void Player::restore(const ActorRecord& r)
+{
+    DamageableObject::restore(r);
+    m_cabbagePower = r.cabbagePower;
+    m_torpedos = r.torpedoes;
+}
+
 //Alien Implementation
-Alien::Alien(StudentWorld* w, double startX, double startY, int imageID, double hitPoints, double damageAmt, double deltaX, double deltaY, double distance, unsigned int scoreValue):DamageableObject(w, startX, startY, imageID, 0, 1.5, 1, hitPoints, damageAmt, deltaX, deltaY, distance)
+Alien::Alien(StudentWorld* w, double startX, double startY, int imageID, double hitPoints, double damageAmt, double deltaX, double deltaY, double distance, unsigned int scoreValue):DamageableObject(w, KIND_ALIEN, startX, startY, imageID, 0, 1.5, 1, hitPoints, damageAmt, deltaX, deltaY, distance)
 {
     m_flightPlan = 0;
     m_scoreValue = scoreValue;
     increaseHitPoints(computeHealth());
 }
 
-bool Alien::isAlien() const
-{
-    return true;
-}
-
 unsigned int Alien::scoreValue() const
 {
     return m_scoreValue;
@@ -280,12 +391,24 @@ bool Alien::damageCollidingPlayer(double amt)
         world()->recordAlienDestroyed();
         possiblyDropGoodie();
         world()->playSound(SOUND_DEATH);
-        world()->addActor(new Explosion(world(), getX(), getY()));
+        world()->spawnActor<Explosion>(getX(), getY());
         return true;
     }
     return false;
 }
 
+void Alien::save(ActorRecord& r) const
+{
+    DamageableObject::save(r);
+    r.flightPlan = m_flightPlan;
+}
+
+void Alien::restore(const ActorRecord& r)
+{
+    DamageableObject::restore(r);
+    m_flightPlan = r.flightPlan;
+}
+
 //protected functions
 double Alien::computeHealth() const
 {
@@ -295,7 +418,7 @@ double Alien::computeHealth() const
 
 void Alien::chooseInitialDirection()
 {
-    int chance = randInt(0, 2);
+    int chance = world()->random(RNG_AI).randInt(0, 2);
     switch (chance) {
         case 0:
             setDeltaY(0.0); //just left (y distance stays constant)
@@ -339,12 +462,12 @@ void Alien::setFlightPlan2()
     if (m_flightPlan == 0){
         chooseInitialDirection();
     }
-    m_flightPlan = randInt(1, 32);
+    m_flightPlan = world()->random(RNG_AI).randInt(1, 32);
 }
 
 void Alien::chooseProjectile()
 {
-    world()->addActor(new Turnip(world(), getX() - 14, getY()));
+    world()->spawnActor<Turnip>(getX() - 14, getY());
 }
 
 void Alien::playAttackSound()
@@ -362,7 +485,7 @@ bool Alien::attack()
 {
     if (world()->playerInLineOfFire(this)) {
         int sampleSize = decideAttackHelper();
-        int r = randInt(1, sampleSize);
+        int r = world()->random(RNG_AI).randInt(1, sampleSize);
         if (r == 1) {
             chooseProjectile();
             playAttackSound();
@@ -386,14 +509,14 @@ Smoregon::Smoregon(StudentWorld* w, double startX, double startY):Alien(w, start
 
 void Smoregon::possiblyDropGoodie()
 {
-    int r1 = randInt(1, 3);
+    int r1 = world()->random(RNG_SPAWN).randInt(1, 3);
     if (r1 == 1) {
-        int r2 = randInt(1, 2);
+        int r2 = world()->random(RNG_SPAWN).randInt(1, 2);
         if (r2 == 1) {
-            world()->addActor(new RepairGoodie(world(), getX(), getY()));
+            world()->spawnActor<RepairGoodie>(getX(), getY());
         }
         else {
-            world()->addActor(new TorpedoGoodie(world(), getX(), getY()));
+            world()->spawnActor<TorpedoGoodie>(getX(), getY());
         }
     }
 }
@@ -402,7 +525,7 @@ void Smoregon::changeFlightPlanAgain()
 {
     int currentLevel = world()->getLevel();
     int sampleSize = (20/currentLevel) + 5;
-    int r = randInt(1, sampleSize);
+    int r = world()->random(RNG_AI).randInt(1, sampleSize);
     if (r == 1) {
         setDeltaY(0.0);
         setFlightPlan(VIEW_WIDTH);
@@ -419,9 +542,9 @@ Snagglegon::Snagglegon(StudentWorld* w, double startX, double startY):Alien(w, s
 
 void Snagglegon::possiblyDropGoodie()
 {
-    int r = randInt(1, 6);
+    int r = world()->random(RNG_SPAWN).randInt(1, 6);
     if (r == 1) {
-        world()->addActor(new ExtraLifeGoodie(world(), getX(), getY()));
+        world()->spawnActor<ExtraLifeGoodie>(getX(), getY());
     }
 }
 
@@ -432,8 +555,7 @@ void Snagglegon::chooseInitialDirection()
 
 void Snagglegon::chooseProjectile()
 {
-    world()->addActor(new AlienLaunchedTorpedo(world(), getX() - 14, getY()));
-    world()->playSound(SOUND_TORPEDO);
+    world()->spawnActor<AlienLaunchedTorpedo>(getX() - 14, getY());
 }
 
 void Snagglegon::playAttackSound()
@@ -448,7 +570,7 @@ int Snagglegon::decideAttackHelper() const
 }
 
 //Projectile Implementation
-Projectile::Projectile(StudentWorld* w, double startX, double startY, int imageID, double damageAmt, double deltaX, bool rotates, int dir):Actor(w, startX, startY, imageID, damageAmt, deltaX, 0.0, 8.0, dir, 0.5, 1)
+Projectile::Projectile(StudentWorld* w, double startX, double startY, int imageID, double damageAmt, double deltaX, bool rotates, int dir):Actor(w, KIND_PROJECTILE, startX, startY, imageID, damageAmt, deltaX, 0.0, 8.0, dir, 0.5, 1)
 {
     m_rotates = rotates;
 }
@@ -470,7 +592,7 @@ void Projectile::doSomething()
             a->sufferDamage(damageAmt(), HIT_BY_PROJECTILE);
             if (a->isDead()) {
                 a->possiblyDropGoodie();
-                world()->addActor(new Explosion(world(), x, y));
+                world()->spawnActor<Explosion>(x, y);
                 world()->recordAlienDestroyed();
                 world()->increaseScore(a->scoreValue());
                 world()->playSound(SOUND_DEATH);
@@ -500,7 +622,7 @@ void Projectile::doSomething()
                 a->sufferDamage(damageAmt(), HIT_BY_PROJECTILE);
                 if (a->isDead()) {
                     a->possiblyDropGoodie();
-                    world()->addActor(new Explosion(world(), x, y));
+                    world()->spawnActor<Explosion>(x, y);
                     world()->recordAlienDestroyed();
                     world()->increaseScore(a->scoreValue());
                     world()->playSound(SOUND_DEATH);
@@ -552,7 +674,7 @@ AlienLaunchedTorpedo::AlienLaunchedTorpedo(StudentWorld* w, double startX, doubl
 }
 
 //Goodie Implementation
-Goodie::Goodie(StudentWorld* w, double startX, double startY, int imageID):Actor(w, startX, startY, imageID, 0.0, -1.0, -1.0, 0.75, 0, 0.5, 1)
+Goodie::Goodie(StudentWorld* w, double startX, double startY, int imageID):Actor(w, KIND_GOODIE, startX, startY, imageID, 0.0, -1.0, -1.0, 0.75, 0, 0.5, 1)
 {
     
 }
@@ -635,22 +757,3 @@ void TorpedoGoodie::grantReward(Player* p)
     p->increaseTorpedoes(5);
 }
 
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
@@ -2,23 +2,68 @@
 #define ACTOR_H_
 
 #include "GraphObject.h"
+#include "ActorBucket.h"
 
 const int HIT_BY_SHIP = 0;
 const int HIT_BY_PROJECTILE = 1;
 
+// Kinds of actor.  StudentWorld keeps the actors of each kind together in
+// their own bucket and lets the buckets act in this order every tick.  The
+// order is a game rule, not just bookkeeping: every alien moves before any
+// projectile does, so whether a projectile hits an alien in a given tick
+// no longer depends on which of the two was spawned first.
+const int KIND_STAR = 0;
+const int KIND_ALIEN = 1;
+const int KIND_PROJECTILE = 2;
+const int KIND_GOODIE = 3;
+const int KIND_EXPLOSION = 4;
+const int NUM_ACTOR_KINDS = 5;
+const int KIND_PLAYER = NUM_ACTOR_KINDS;  //the player has a bucket of its own, after the others
+
 class StudentWorld;
 
+// Everything about an actor that can change during play, and nothing that
+// points anywhere, so a whole world can be saved into a flat buffer.  The
+// image ID (and, for torpedoes, the sign of deltaX) says which class of
+// actor to rebuild; fields a class doesn't have are left zero.
+struct ActorRecord
+{
+    int imageID;
+    int direction;
+    int dead;
+    int cycle;  //Explosion
+    int cabbagePower;  //Player
+    int torpedoes;  //Player
+    double x;
+    double y;
+    double size;
+    double deltaX;
+    double deltaY;
+    double distance;
+    double hitPoints;  //DamageableObject
+    double flightPlan;  //Alien
+};
+
 class Actor : public GraphObject
 {
 public:
-    Actor(StudentWorld* w, double startX, double startY, int imageID,
+    Actor(StudentWorld* w, int kind, double startX, double startY, int imageID,
           double damageAmt, double deltaX, double deltaY, double distance, int imageDir, double size, int depth);
     // Action to perform for each tick.
     virtual void doSomething() = 0;
+    // Where this actor is and how big it is for collisions.  These (like
+    // the velocity, hit points and dead flag) are kept in the actor's slot
+    // of its world's bucket for its kind, not in the actor itself.
+    double getX() const;
+    double getY() const;
+    double getRadius() const;
+    void setSize(double size);
     // Is this actor dead?
     bool isDead() const;
     // Is this actor an alien?
-    virtual bool isAlien() const;
+    bool isAlien() const;
+    // What kind of actor is this?
+    int kind() const;
     // Get this actor's world
     StudentWorld* world() const;
     //Get this actor's damageAmount
@@ -38,13 +83,28 @@ public:
     // Move this actor to x,y if onscreen; otherwise, don't move and mark
     // this actor as dead.
     virtual void moveTo(double x, double y);
+    // Which cell of the world's spatial grid this actor is in, or -1 if it
+    // isn't in the grid.
+    int gridCell() const;
+    void setGridCell(int cell);
+    // Which slot of its bucket this actor's fields are in.  Only the bucket
+    // moves actors from slot to slot.
+    int slot() const;
+    void setSlot(int slot);
+    // Save everything about this actor that can change during play into r.
+    virtual void save(ActorRecord& r) const;
+    // Take back everything save put into r.  The actor must already be at
+    // r's position, of the class that wrote r.
+    virtual void restore(const ActorRecord& r);
+protected:
+    ActorBucket* bucket() const;
 private:
-    bool m_isDead;
+    int m_kind;
+    int m_gridCell;
+    int m_slot;
+    ActorBucket* m_bucket;
     StudentWorld* m_world;
     double m_damageAmt;
-    double m_deltaX; 
-    double m_deltaY;
-    double m_distance;
 };
 
 class Star : public Actor
@@ -52,6 +112,9 @@ class Star : public Actor
 public:
     Star(StudentWorld* w, double startX, double startY, double size);
     virtual void doSomething();
+    // Do what doSomething does for every live star in stars at once,
+    // working straight on the bucket's arrays.
+    static void moveAll(ActorBucket& stars);
 };
 
 class Explosion : public Actor
@@ -59,6 +122,8 @@ class Explosion : public Actor
 public:
     Explosion(StudentWorld* w, double startX, double startY);
     virtual void doSomething();
+    virtual void save(ActorRecord& r) const;
+    virtual void restore(const ActorRecord& r);
 private:
     int m_cycle; //keep track of time after 4 ticks
 };
@@ -66,7 +131,7 @@ private:
 class DamageableObject : public Actor
 {
 public:
-    DamageableObject(StudentWorld* w, double startX, double startY, int imageID, int startDir, double size, int depth, double hitPoints, double damageAmt, double deltaX, double deltaY, double distance);
+    DamageableObject(StudentWorld* w, int kind, double startX, double startY, int imageID, int startDir, double size, int depth, double hitPoints, double damageAmt, double deltaX, double deltaY, double distance);
     // How many hit points does this actor have left?
     double hitPoints() const;
     // Increase this actor's hit points by amt.
@@ -74,8 +139,8 @@ public:
     // This actor suffers an amount of damage caused by being hit by either
     // a ship or a projectile (see constants above).
     void sufferDamage(double amt, int cause);
-private:
-    double m_hitPoints;
+    virtual void save(ActorRecord& r) const;
+    virtual void restore(const ActorRecord& r);
 };
 
 const int MAX_CABBAGE_POWER = 30;
@@ -94,6 +159,8 @@ public:
     int cabbagePct() const;
     // Get the number of torpedoes the player has.
     int numTorpedoes() const;
+    virtual void save(ActorRecord& r) const;
+    virtual void restore(const ActorRecord& r);
 private:
     int m_cabbagePower;
     int m_torpedos;
@@ -105,7 +172,6 @@ public:
     Alien(StudentWorld* w, double startX, double startY, int imageID,
           double hitPoints, double damageAmt, double deltaX,
           double deltaY, double distance, unsigned int scoreValue);
-    virtual bool isAlien() const;
     unsigned int scoreValue() const;
     virtual void doSomething();
     // If this alien collided with the player, damage the player and return
@@ -113,6 +179,8 @@ public:
     bool damageCollidingPlayer(double amt);
     // If this alien drops goodies, drop one with the appropriate probability.
     virtual void possiblyDropGoodie() = 0;
+    virtual void save(ActorRecord& r) const;
+    virtual void restore(const ActorRecord& r);
 protected:
     double computeHealth() const;
     virtual void chooseInitialDirection();
@@ -234,4 +302,41 @@ private:
     virtual void grantReward(Player* p);
 };
 
+//the fields kept in the bucket are read for nearly every actor every tick,
+//so their accessors are defined here where the world's loops can inline them
+inline double Actor::getX() const
+{
+    return m_bucket->x[m_slot];
+}
+
+inline double Actor::getY() const
+{
+    return m_bucket->y[m_slot];
+}
+
+inline double Actor::getRadius() const
+{
+    return m_bucket->radius[m_slot];
+}
+
+inline bool Actor::isDead() const
+{
+    return m_bucket->dead[m_slot] != 0;
+}
+
+inline double Actor::distance() const
+{
+    return m_bucket->speed[m_slot];
+}
+
+inline double Actor::deltaX() const
+{
+    return m_bucket->deltaX[m_slot];
+}
+
+inline double Actor::deltaY() const
+{
+    return m_bucket->deltaY[m_slot];
+}
+
 #endif // ACTOR_H_
@@ -0,0 +1,80 @@
+#ifndef ACTORBUCKET_H_
+#define ACTORBUCKET_H_
+
+#include <vector>
+#include <cstddef>
+
+class Actor;
+
+// The actors of one kind.  The fields that the tick loop reads or writes
+// for nearly every actor (position, collision radius, velocity, hit points
+// and whether it's dead) are kept here in parallel arrays, one slot per
+// actor, so a loop over a kind walks straight through memory instead of
+// hopping from object to object.  Each actor knows its bucket and slot and
+// keeps those fields nowhere else; everything else about it stays in the
+// actor object.
+struct ActorBucket
+{
+    std::vector<Actor*> actors;
+    std::vector<double> x;
+    std::vector<double> y;
+    std::vector<double> radius;
+    std::vector<double> deltaX;
+    std::vector<double> deltaY;
+    std::vector<double> speed;  //distance travelled per tick
+    std::vector<double> hitPoints;  //zero for actors that can't be damaged
+    std::vector<unsigned char> dead;
+
+    std::size_t size() const
+    {
+        return actors.size();
+    }
+
+    // Give actor a a new slot at the end and return its index.
+    int add(Actor* a, double startX, double startY, double r, double dx, double dy, double d)
+    {
+        actors.push_back(a);
+        x.push_back(startX);
+        y.push_back(startY);
+        radius.push_back(r);
+        deltaX.push_back(dx);
+        deltaY.push_back(dy);
+        speed.push_back(d);
+        hitPoints.push_back(0.0);
+        dead.push_back(0);
+        return static_cast<int>(actors.size()) - 1;
+    }
+
+    // Move slot from into slot to (which must be free), keeping the actor
+    // in it pointed at the right place.
+    void moveSlot(std::size_t from, std::size_t to);
+
+    // Drop every slot from n on.
+    void truncate(std::size_t n)
+    {
+        actors.resize(n);
+        x.resize(n);
+        y.resize(n);
+        radius.resize(n);
+        deltaX.resize(n);
+        deltaY.resize(n);
+        speed.resize(n);
+        hitPoints.resize(n);
+        dead.resize(n);
+    }
+
+    void reserve(std::size_t n)
+    {
+        actors.reserve(n);
+        x.reserve(n);
+        y.reserve(n);
+        radius.reserve(n);
+        deltaX.reserve(n);
+        deltaY.reserve(n);
+        speed.reserve(n);
+        hitPoints.reserve(n);
+        dead.reserve(n);
+    }
+};
+
+#endif // ACTORBUCKET_H_
@@ -0,0 +1,104 @@
+#include "ActorPool.h"
+#include <new>
+using namespace std;
+
+// Every block starts with ALIGNMENT bytes recording its size class, so
+// release doesn't need to be told how big the object was.  Objects too big
+// for any size class get a header of OVERSIZE and come straight from the
+// global allocator.
+static const int OVERSIZE = -1;
+
+ActorPool::ActorPool()
+{
+    for (int i = 0; i < NUM_SIZE_CLASSES; i++) {
+        m_freeLists[i] = nullptr;
+        m_numFree[i] = 0;
+    }
+    m_chunks = nullptr;
+    m_globalAllocations = 0;
+}
+
+ActorPool::~ActorPool()
+{
+    while (m_chunks != nullptr) {
+        Chunk* next = m_chunks->next;
+        ::operator delete(m_chunks);
+        m_chunks = next;
+    }
+}
+
+void* ActorPool::allocate(size_t size)
+{
+    int sizeClass = static_cast<int>((size + ALIGNMENT - 1) / ALIGNMENT) - 1;
+    if (sizeClass >= NUM_SIZE_CLASSES) {
+        m_globalAllocations++;
+        char* raw = static_cast<char*>(::operator new(ALIGNMENT + size));
+        *reinterpret_cast<int*>(raw) = OVERSIZE;
+        return raw + ALIGNMENT;
+    }
+    if (m_freeLists[sizeClass] == nullptr) {
+        refill(sizeClass);
+    }
+    Block* b = m_freeLists[sizeClass];
+    m_freeLists[sizeClass] = b->next;
+    m_numFree[sizeClass]--;
+    char* raw = reinterpret_cast<char*>(b);
+    *reinterpret_cast<int*>(raw) = sizeClass;
+    return raw + ALIGNMENT;
+}
+
+void ActorPool::release(void* p)
+{
+    if (p == nullptr) {
+        return;
+    }
+    char* raw = static_cast<char*>(p) - ALIGNMENT;
+    int sizeClass = *reinterpret_cast<int*>(raw);
+    if (sizeClass == OVERSIZE) {
+        ::operator delete(raw);
+        return;
+    }
+    Block* b = reinterpret_cast<Block*>(raw);
+    b->next = m_freeLists[sizeClass];
+    m_freeLists[sizeClass] = b;
+    m_numFree[sizeClass]++;
+}
+
+void ActorPool::reserve(size_t size, int count)
+{
+    int sizeClass = static_cast<int>((size + ALIGNMENT - 1) / ALIGNMENT) - 1;
+    if (sizeClass >= NUM_SIZE_CLASSES) {
+        return;
+    }
+    while (m_numFree[sizeClass] < count) {
+        refill(sizeClass);
+    }
+}
+
+unsigned long ActorPool::globalAllocations() const
+{
+    return m_globalAllocations;
+}
+
+//carve a fresh chunk into blocks of one size class
+void ActorPool::refill(int sizeClass)
+{
+    size_t stride = ALIGNMENT + blockSize(sizeClass);
+    m_globalAllocations++;
+    char* raw = static_cast<char*>(::operator new(ALIGNMENT + BLOCKS_PER_CHUNK * stride));
+    Chunk* c = reinterpret_cast<Chunk*>(raw);
+    c->next = m_chunks;
+    m_chunks = c;
+    char* first = raw + ALIGNMENT;
+    for (int i = BLOCKS_PER_CHUNK - 1; i >= 0; i--) {
+        Block* b = reinterpret_cast<Block*>(first + i * stride);
+        b->next = m_freeLists[sizeClass];
+        m_freeLists[sizeClass] = b;
+    }
+    m_numFree[sizeClass] += BLOCKS_PER_CHUNK;
+}
+
+size_t ActorPool::blockSize(int sizeClass)
+{
+    return (sizeClass + 1) * ALIGNMENT;
+}
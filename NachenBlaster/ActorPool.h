@@ -0,0 +1,47 @@
+#ifndef ACTORPOOL_H_
+#define ACTORPOOL_H_
+
+#include <cstddef>
+
+// Recycles the memory of actors that come and go during play.  Blocks are
+// segregated into size classes of 16 bytes, and every actor type always
+// lands in the same class, so a Cabbage that dies frees exactly the block
+// the next Cabbage will use.  Memory is taken from the global allocator a
+// chunk at a time and only given back when the pool is destroyed.
+class ActorPool
+{
+public:
+    ActorPool();
+    ~ActorPool();
+    // Return storage for an object of the given size.
+    void* allocate(std::size_t size);
+    // Give back storage obtained from allocate.
+    void release(void* p);
+    // Make sure at least count blocks big enough for size bytes are free.
+    void reserve(std::size_t size, int count);
+    // How many times has this pool called the global allocator?
+    unsigned long globalAllocations() const;
+private:
+    static const std::size_t ALIGNMENT = 16;
+    static const int NUM_SIZE_CLASSES = 16;  //blocks of up to 256 bytes
+    static const int BLOCKS_PER_CHUNK = 64;
+    struct Block
+    {
+        Block* next;  //while on a free list
+    };
+    struct Chunk
+    {
+        Chunk* next;
+    };
+    Block* m_freeLists[NUM_SIZE_CLASSES];
+    int m_numFree[NUM_SIZE_CLASSES];
+    Chunk* m_chunks;
+    unsigned long m_globalAllocations;
+    void refill(int sizeClass);
+    static std::size_t blockSize(int sizeClass);
+    // Prevent copying or assigning ActorPools
+    ActorPool(const ActorPool&) = delete;
+    ActorPool& operator=(const ActorPool&) = delete;
+};
+
+#endif // ACTORPOOL_H_
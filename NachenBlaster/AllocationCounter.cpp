@@ -0,0 +1,36 @@
+#include "AllocationCounter.h"
+#include <new>
+#include <atomic>
+#include <cstdlib>
+#include <cstddef>
+using namespace std;
+
+  // Only the plain forms are replaced: the library's array and nothrow
+  // forms call these, and the aligned forms (which nothing here uses) keep
+  // their own matching pair.  This lives in a translation unit of its own
+  // so the compiler never sees a free() inlined against a new-expression.
+
+static atomic<unsigned long long> s_globalAllocations(0);
+
+unsigned long long globalAllocationCount()
+{
+	return s_globalAllocations.load(memory_order_relaxed);
+}
+
+void* operator new(size_t size)
+{
+	s_globalAllocations.fetch_add(1, memory_order_relaxed);
+	if (void* p = malloc(size == 0 ? 1 : size))
+		return p;
+	throw bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+	free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+	free(p);
+}
@@ -0,0 +1,11 @@
+#ifndef ALLOCATIONCOUNTER_H_
+#define ALLOCATIONCOUNTER_H_
+
+  // Linking AllocationCounter.cpp into a program replaces the global
+  // operator new and operator delete with ones that count every call to
+  // the global allocator, so a benchmark can see how much of it comes from
+  // the tick loop.  The game itself doesn't link it.
+
+unsigned long long globalAllocationCount();
+
+#endif // ALLOCATIONCOUNTER_H_
@@ -0,0 +1,181 @@
+#include "AssetLoader.h"
+#include "AtlasLayout.h"
+#include <algorithm>
+using namespace std;
+
+static string assetPath(const string& assetDir, const char* fileName)
+{
+	string path = assetDir;
+	if (!path.empty())
+		path += '/';
+	return path + fileName;
+}
+
+  // Decode every TGA file at once, then lay the sprites out and copy them
+  // into their pages, a sprite per task (their places, gutters and all,
+  // never overlap).
+
+static bool loadLooseSprites(const string& assetDir, int atlasSize, TaskPool& pool,
+							 LoadedAssets& assets, string& error)
+{
+	vector<vector<char>> images(NUM_GAME_SPRITES);
+	vector<AtlasPageSize> sizes(NUM_GAME_SPRITES);
+	vector<char> decoded(NUM_GAME_SPRITES);
+	pool.parallelFor(NUM_GAME_SPRITES, [&](int k) {
+		decoded[k] = decodeTga(assetPath(assetDir, GAME_SPRITES[k].tgaFileName),
+							   sizes[k].width, sizes[k].height, images[k]);
+	});
+	for (int k = 0; k < NUM_GAME_SPRITES; k++)
+	{
+		if (!decoded[k])
+		{
+			error = "Cannot read " + assetPath(assetDir, GAME_SPRITES[k].tgaFileName);
+			return false;
+		}
+	}
+
+	vector<AtlasPlacement> placements;
+	vector<AtlasPageSize> pageSizes;
+	if (!layOutAtlas(sizes, atlasSize, placements, pageSizes))
+	{
+		error = "A sprite is too big for a texture atlas";
+		return false;
+	}
+	assets.pages.resize(pageSizes.size());
+	for (size_t p = 0; p < pageSizes.size(); p++)
+	{
+		LoadedPage& page = assets.pages[p];
+		page.width = pageSizes[p].width;
+		page.height = pageSizes[p].height;
+		page.pixels.assign(static_cast<size_t>(page.width) * page.height * 4, 0);
+	}
+	pool.parallelFor(NUM_GAME_SPRITES, [&](int k) {
+		const AtlasPlacement& at = placements[k];
+		LoadedPage& page = assets.pages[at.page];
+		blitWithGutter(images[k].data(), sizes[k].width, sizes[k].height,
+					   page.pixels.data(), page.width, at.x, at.y);
+	});
+	for (int k = 0; k < NUM_GAME_SPRITES; k++)
+	{
+		const AtlasPlacement& at = placements[k];
+		LoadedSprite s = { GAME_SPRITES[k].imageID, GAME_SPRITES[k].frameNum, at.page,
+						   at.x, at.y, sizes[k].width, sizes[k].height };
+		assets.sprites.push_back(s);
+	}
+	return true;
+}
+
+  // Everything in a pack is ready as it is.  (AssetPack::open has checked
+  // that its pages are numbered 0 up and its sprites lie inside them.)
+
+static bool loadPackedSprites(const AssetPack& pack, int atlasSize, LoadedAssets& assets, string& error)
+{
+	size_t numPages = 0;
+	for (const AssetEntry& e : pack.entries())
+	{
+		if (e.kind == ASSET_ATLAS_PAGE)
+			numPages++;
+	}
+	assets.pages.resize(numPages);
+	for (const AssetEntry& e : pack.entries())
+	{
+		if (e.kind == ASSET_ATLAS_PAGE)
+		{
+			if (e.width > static_cast<uint32_t>(atlasSize)  ||  e.height > static_cast<uint32_t>(atlasSize))
+			{
+				error = "The asset pack's atlas is too big for this OpenGL";
+				return false;
+			}
+			assets.pages[e.id].width = e.width;
+			assets.pages[e.id].height = e.height;
+		}
+		else if (e.kind == ASSET_SPRITE)
+		{
+			LoadedSprite s = { static_cast<int>(e.id), static_cast<int>(e.frame), static_cast<int>(e.page),
+							   static_cast<int>(e.x), static_cast<int>(e.y),
+							   static_cast<int>(e.width), static_cast<int>(e.height) };
+			assets.sprites.push_back(s);
+		}
+	}
+	return true;
+}
+
+void loadSounds(const string& assetDir, const AssetPack* pack, TaskPool& pool,
+				vector<LoadedSound>& sounds)
+{
+	sounds.clear();
+	if (pack != nullptr  &&  pack->isOpen())
+	{
+		for (const AssetEntry& e : pack->entries())
+		{
+			if (e.kind != ASSET_SOUND)
+				continue;
+			LoadedSound s;
+			s.soundID = e.id;
+			s.clip.mapped = static_cast<const int16_t*>(pack->payload(e));
+			s.clip.mappedFrames = e.width;
+			sounds.push_back(s);
+		}
+		return;
+	}
+
+	vector<LoadedSound> decoded(NUM_GAME_SOUNDS);
+	vector<char> ok(NUM_GAME_SOUNDS);
+	pool.parallelFor(NUM_GAME_SOUNDS, [&](int k) {
+		decoded[k].soundID = GAME_SOUNDS[k].soundID;
+		ok[k] = decodeWav(assetPath(assetDir, GAME_SOUNDS[k].wavFileName), decoded[k].clip);
+	});
+	for (int k = 0; k < NUM_GAME_SOUNDS; k++)
+	{
+		if (ok[k])
+			sounds.push_back(move(decoded[k]));
+	}
+}
+
+bool loadSprites(const string& assetDir, const AssetPack* pack, int atlasSize,
+				 bool mipmapped, TaskPool& pool, LoadedAssets& assets, string& error)
+{
+	assets.pages.clear();
+	assets.sprites.clear();
+	bool loaded = (pack != nullptr  &&  pack->isOpen())
+					? loadPackedSprites(*pack, atlasSize, assets, error)
+					: loadLooseSprites(assetDir, atlasSize, pool, assets, error);
+	if (!loaded)
+		return false;
+
+	int maxLevels = 0;
+	for (size_t p = 0; p < assets.pages.size(); p++)
+	{
+		LoadedPage& page = assets.pages[p];
+		const char* level0 = page.pixels.data();
+		if (pack != nullptr  &&  pack->isOpen())
+			level0 = static_cast<const char*>(pack->payload(*pack->find(ASSET_ATLAS_PAGE, static_cast<int>(p))));
+		page.mips.reset(page.width, page.height, level0, mipmapped ? ATLAS_MAX_MIP_LEVEL : 0);
+		maxLevels = max(maxLevels, page.mips.numLevels());
+	}
+
+	  // Each level needs the one before it, so the levels go one at a time,
+	  // with every page's rows split into bands across the threads.
+	const int bandsPerPage = 2 * pool.numThreads();
+	for (int level = 1; level < maxLevels; level++)
+	{
+		pool.parallelFor(static_cast<int>(assets.pages.size()) * bandsPerPage, [&](int k) {
+			MipChain& mips = assets.pages[k / bandsPerPage].mips;
+			if (level >= mips.numLevels())
+				return;
+			int band = k % bandsPerPage;
+			int rows = mips.height(level);
+			mips.buildRows(level, rows * band / bandsPerPage, rows * (band + 1) / bandsPerPage);
+		});
+	}
+	return true;
+}
+
+bool loadAssets(const string& assetDir, const AssetPack* pack, int atlasSize,
+				bool mipmapped, TaskPool& pool, LoadedAssets& assets, string& error)
+{
+	if (!loadSprites(assetDir, pack, atlasSize, mipmapped, pool, assets, error))
+		return false;
+	loadSounds(assetDir, pack, pool, assets.sounds);
+	return true;
+}
@@ -0,0 +1,65 @@
+#ifndef ASSETLOADER_H_
+#define ASSETLOADER_H_
+
+#include "AssetPack.h"
+#include "AudioMixer.h"
+#include "Mipmap.h"
+#include "TaskPool.h"
+#include <string>
+#include <vector>
+
+  // Every sprite and sound the game needs, ready to hand to OpenGL and the
+  // mixer with nothing left to do but the uploads.
+
+struct LoadedPage
+{
+	int				  width;
+	int				  height;
+	std::vector<char> pixels;	// BGRA, unless they're in an AssetPack
+	MipChain		  mips;		// level 0 is the whole page
+};
+
+struct LoadedSprite
+{
+	int imageID;
+	int frameNum;
+	int page;
+	int x;	// where in the page
+	int y;
+	int width;
+	int height;
+};
+
+struct LoadedSound
+{
+	int		soundID;
+	PcmClip clip;	// mapped from the AssetPack, if it came from one
+};
+
+struct LoadedAssets
+{
+	std::vector<LoadedPage>	  pages;
+	std::vector<LoadedSprite> sprites;
+	std::vector<LoadedSound>  sounds;
+};
+
+  // Load every sprite and sound in GAME_SPRITES and GAME_SOUNDS, sharing
+  // the work among pool's threads: from pack if it's open (which must then
+  // outlive the assets), or else by decoding the loose files in assetDir
+  // and laying the sprites out in atlas pages.  No page may be bigger than
+  // atlasSize on a side.  If mipmapped, each page's mipmaps are built too,
+  // down to ATLAS_MAX_MIP_LEVEL.
+  // Sounds that can't be read are left out.  Returns false, saying why in
+  // error, if a sprite can't be had.  Needs no OpenGL.
+bool loadAssets(const std::string& assetDir, const AssetPack* pack, int atlasSize,
+				bool mipmapped, TaskPool& pool, LoadedAssets& assets, std::string& error);
+
+  // The two halves of loadAssets, for a caller that needs the sounds
+  // straight away but can let the sprites come later: loadSprites fills in
+  // just the pages and sprites, and loadSounds just the sounds.
+bool loadSprites(const std::string& assetDir, const AssetPack* pack, int atlasSize,
+				 bool mipmapped, TaskPool& pool, LoadedAssets& assets, std::string& error);
+void loadSounds(const std::string& assetDir, const AssetPack* pack, TaskPool& pool,
+				std::vector<LoadedSound>& sounds);
+
+#endif // ASSETLOADER_H_
@@ -0,0 +1,386 @@
+#include "AssetPack.h"
+#include "AssetLoader.h"
+#include "AtlasLayout.h"
+#include "GameConstants.h"
+#include <fstream>
+#include <algorithm>
+#include <iterator>
+#include <cstring>
+#if !defined(_MSC_VER)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+using namespace std;
+
+const SpriteAsset GAME_SPRITES[] = {
+	{ IID_NACHENBLASTER , 0, "ship.tga"},
+	{ IID_SMALLGON, 0, "smallgon.tga" },
+	{ IID_SMOREGON, 0, "smoregon.tga" },
+	{ IID_SNAGGLEGON, 0, "snagglegon.tga" },
+	{ IID_REPAIR_GOODIE, 0, "health.tga" },
+	{ IID_LIFE_GOODIE, 0, "life.tga" },
+	{ IID_TORPEDO_GOODIE, 0, "sonar.tga" },
+	{ IID_TORPEDO, 0, "torpedo.tga" },
+	{ IID_TURNIP, 0, "turnip.tga" },
+	{ IID_CABBAGE, 0, "cabbage.tga"},
+	{ IID_STAR, 0, "star1.tga" },
+	{ IID_EXPLOSION, 0, "explosion.tga" },
+};
+const int NUM_GAME_SPRITES = sizeof(GAME_SPRITES) / sizeof(GAME_SPRITES[0]);
+
+const SoundAsset GAME_SOUNDS[] = {
+	{ SOUND_THEME          , "theme.wav" },
+	{ SOUND_GOODIE         , "goodie.wav" },
+	{ SOUND_BLAST          , "ouch.wav" },
+	{ SOUND_PLAYER_SHOOT   , "laser.wav" },
+	{ SOUND_ALIEN_SHOOT    , "laser2.wav" },
+	{ SOUND_FINISHED_LEVEL , "finished.wav" },
+	{ SOUND_DEATH          , "blowup.wav" },
+	{ SOUND_TORPEDO        , "torpedo.wav" },
+};
+const int NUM_GAME_SOUNDS = sizeof(GAME_SOUNDS) / sizeof(GAME_SOUNDS[0]);
+
+static const char PACK_MAGIC[4] = { 'N', 'B', 'P', 'K' };
+static const size_t PACK_HEADER_SIZE = 16;
+static const size_t PACK_ENTRY_SIZE = 10 * 4 + 2 * 8;
+
+static uint64_t getLittleEndian(const unsigned char* p, int n)
+{
+	uint64_t v = 0;
+	for (int k = 0; k < n; k++)
+		v |= static_cast<uint64_t>(p[k]) << (8 * k);
+	return v;
+}
+
+static void putLittleEndian(vector<unsigned char>& out, uint64_t v, int n)
+{
+	for (int k = 0; k < n; k++)
+		out.push_back(static_cast<unsigned char>(v >> (8 * k)));
+}
+
+  // Copy one pixel from a TGA file as BGRA
+
+static void putTgaPixel(const unsigned char* src, int byteCount, char* to)
+{
+	if (byteCount == 1)  // greyscale
+		to[0] = to[1] = to[2] = src[0];
+	else
+	{
+		for (int c = 0; c < 3; c++)
+			to[c] = src[c];
+	}
+	to[3] = (byteCount == 4 ? src[3] : static_cast<char>(255));
+}
+
+bool decodeTga(const string& path, int& width, int& height, vector<char>& bgra)
+{
+	ifstream file(path, ios::in | ios::binary);
+	if (!file)
+		return false;
+	file.seekg(0, ios::end);
+	streamoff fileSize = file.tellg();
+	file.seekg(0);
+	if (fileSize < 18)
+		return false;
+	vector<unsigned char> data(static_cast<size_t>(fileSize));
+	if (!file.read(reinterpret_cast<char*>(data.data()), data.size()))
+		return false;
+
+	  // image type 2 (color) or 3 (greyscale), or 10 or 11 for the same run
+	  // length encoded, with no color map
+	int idLength = data[0];
+	int imageType = data[2];
+	bool rle = (imageType == 10  ||  imageType == 11);
+	if (data[1] != 0  ||  (imageType != 2  &&  imageType != 3  &&  !rle))
+		return false;
+	width = static_cast<int>(getLittleEndian(&data[12], 2));
+	height = static_cast<int>(getLittleEndian(&data[14], 2));
+	int byteCount = data[16] / 8;
+	bool greyscale = (imageType == 3  ||  imageType == 11);
+	if (byteCount != 3  &&  byteCount != 4  &&  !(greyscale  &&  byteCount == 1))
+		return false;
+
+	size_t numPixels = static_cast<size_t>(width) * height;
+	size_t pos = 18 + idLength;
+	bgra.resize(numPixels * 4);
+	if (!rle)
+	{
+		if (data.size() < pos + numPixels * byteCount)
+			return false;
+		for (size_t k = 0; k < numPixels; k++)
+			putTgaPixel(&data[pos + byteCount*k], byteCount, &bgra[4*k]);
+	}
+	else
+	{
+		  // Packets of up to 128 pixels: a header byte with the top bit set
+		  // means one pixel repeated, clear means that many pixels as is
+		for (size_t k = 0; k < numPixels; )
+		{
+			if (pos >= data.size())
+				return false;
+			int header = data[pos++];
+			size_t count = min(static_cast<size_t>((header & 0x7f) + 1), numPixels - k);
+			bool repeated = (header & 0x80) != 0;
+			size_t needed = (repeated ? 1 : count) * byteCount;
+			if (data.size() - pos < needed)
+				return false;
+			for (size_t n = 0; n < count; n++, k++)
+				putTgaPixel(&data[pos + (repeated ? 0 : n * byteCount)], byteCount, &bgra[4*k]);
+			pos += needed;
+		}
+	}
+
+	  // OpenGL wants the bottom row first, as most TGA files have it
+	if (data[17] & 0x20)
+	{
+		size_t rowBytes = static_cast<size_t>(width) * 4;
+		for (int y = 0; y < height / 2; y++)
+			swap_ranges(bgra.begin() + y * rowBytes, bgra.begin() + (y + 1) * rowBytes,
+						bgra.begin() + (height - 1 - y) * rowBytes);
+	}
+	return true;
+}
+
+bool writeAssetPack(const string& assetDir, const string& packPath, string& error)
+{
+	TaskPool pool;
+	LoadedAssets assets;
+	if (!loadAssets(assetDir, nullptr, MAX_ATLAS_SIZE, false, pool, assets, error))
+		return false;
+
+	  // The index, with payloads placed after it.  Sounds that couldn't be
+	  // read were left out, so the game plays them as silence, just as it
+	  // would from loose files.
+	vector<AssetEntry> entries;
+	vector<const void*> payloads;
+	for (size_t p = 0; p < assets.pages.size(); p++)
+	{
+		const LoadedPage& page = assets.pages[p];
+		AssetEntry e = { ASSET_ATLAS_PAGE, static_cast<uint32_t>(p), 0, ASSET_FORMAT_BGRA8,
+						 static_cast<uint32_t>(page.width), static_cast<uint32_t>(page.height),
+						 0, 0, 0, 0, page.pixels.size() };
+		entries.push_back(e);
+		payloads.push_back(page.pixels.data());
+	}
+	for (const LoadedSprite& s : assets.sprites)
+	{
+		AssetEntry e = { ASSET_SPRITE, static_cast<uint32_t>(s.imageID), static_cast<uint32_t>(s.frameNum),
+						 ASSET_FORMAT_NONE, static_cast<uint32_t>(s.width), static_cast<uint32_t>(s.height),
+						 static_cast<uint32_t>(s.page), static_cast<uint32_t>(s.x), static_cast<uint32_t>(s.y),
+						 0, 0 };
+		entries.push_back(e);
+		payloads.push_back(nullptr);
+	}
+	for (const LoadedSound& s : assets.sounds)
+	{
+		AssetEntry e = { ASSET_SOUND, static_cast<uint32_t>(s.soundID), 0, ASSET_FORMAT_PCM16,
+						 static_cast<uint32_t>(s.clip.numFrames()), AUDIO_CHANNELS,
+						 0, 0, 0, 0, s.clip.samples.size() * sizeof(int16_t) };
+		entries.push_back(e);
+		payloads.push_back(s.clip.samples.data());
+	}
+	uint64_t offset = PACK_HEADER_SIZE + PACK_ENTRY_SIZE * entries.size();
+	for (AssetEntry& e : entries)
+	{
+		if (e.size == 0)
+			continue;
+		offset = (offset + ASSET_PACK_ALIGNMENT - 1) / ASSET_PACK_ALIGNMENT * ASSET_PACK_ALIGNMENT;
+		e.offset = offset;
+		offset += e.size;
+	}
+
+	vector<unsigned char> index(PACK_MAGIC, PACK_MAGIC + 4);
+	putLittleEndian(index, ASSET_PACK_VERSION, 4);
+	putLittleEndian(index, entries.size(), 4);
+	putLittleEndian(index, 0, 4);
+	for (const AssetEntry& e : entries)
+	{
+		putLittleEndian(index, e.kind, 4);
+		putLittleEndian(index, e.id, 4);
+		putLittleEndian(index, e.frame, 4);
+		putLittleEndian(index, e.format, 4);
+		putLittleEndian(index, e.width, 4);
+		putLittleEndian(index, e.height, 4);
+		putLittleEndian(index, e.page, 4);
+		putLittleEndian(index, e.x, 4);
+		putLittleEndian(index, e.y, 4);
+		putLittleEndian(index, 0, 4);
+		putLittleEndian(index, e.offset, 8);
+		putLittleEndian(index, e.size, 8);
+	}
+
+	ofstream file(packPath, ios::out | ios::binary | ios::trunc);
+	if (!file)
+	{
+		error = "Cannot create " + packPath;
+		return false;
+	}
+	file.write(reinterpret_cast<const char*>(index.data()), index.size());
+	uint64_t written = index.size();
+	vector<char> padding(ASSET_PACK_ALIGNMENT, 0);
+	for (size_t k = 0; k < entries.size(); k++)
+	{
+		if (entries[k].size == 0)
+			continue;
+		file.write(padding.data(), entries[k].offset - written);
+		file.write(static_cast<const char*>(payloads[k]), entries[k].size);
+		written = entries[k].offset + entries[k].size;
+	}
+	if (!file)
+	{
+		error = "Cannot write " + packPath;
+		return false;
+	}
+	return true;
+}
+
+AssetPack::AssetPack()
+ : m_base(nullptr), m_size(0)
+{
+}
+
+AssetPack::~AssetPack()
+{
+	close();
+}
+
+bool AssetPack::open(const string& path)
+{
+	close();
+#if defined(_MSC_VER)
+	ifstream file(path, ios::in | ios::binary);
+	if (!file)
+		return false;
+	m_buffer.assign(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+	if (m_buffer.empty())
+		return false;
+	m_base = m_buffer.data();
+	m_size = m_buffer.size();
+#else
+	int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+	struct stat st;
+	if (fstat(fd, &st) != 0  ||  st.st_size == 0)
+	{
+		::close(fd);
+		return false;
+	}
+	void* base = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);  // the mapping stays
+	if (base == MAP_FAILED)
+		return false;
+	  // Everything in the pack is about to be used, so start reading it all in
+	madvise(base, st.st_size, MADV_WILLNEED);
+	m_base = static_cast<const unsigned char*>(base);
+	m_size = st.st_size;
+#endif
+	if (!readIndex())
+	{
+		close();
+		return false;
+	}
+	return true;
+}
+
+void AssetPack::close()
+{
+#if !defined(_MSC_VER)
+	if (m_base != nullptr)
+		munmap(const_cast<unsigned char*>(m_base), m_size);
+#endif
+	m_base = nullptr;
+	m_size = 0;
+	m_buffer.clear();
+	m_entries.clear();
+}
+
+  // Read the index, checking that every payload is in the file and is the
+  // size its entry says
+
+bool AssetPack::readIndex()
+{
+	if (m_size < PACK_HEADER_SIZE  ||  memcmp(m_base, PACK_MAGIC, 4) != 0  ||
+		getLittleEndian(m_base + 4, 4) != ASSET_PACK_VERSION)
+		return false;
+	uint64_t numEntries = getLittleEndian(m_base + 8, 4);
+	if (numEntries > (m_size - PACK_HEADER_SIZE) / PACK_ENTRY_SIZE)
+		return false;
+
+	m_entries.resize(static_cast<size_t>(numEntries));
+	const unsigned char* p = m_base + PACK_HEADER_SIZE;
+	for (AssetEntry& e : m_entries)
+	{
+		e.kind = static_cast<uint32_t>(getLittleEndian(p, 4));
+		e.id = static_cast<uint32_t>(getLittleEndian(p + 4, 4));
+		e.frame = static_cast<uint32_t>(getLittleEndian(p + 8, 4));
+		e.format = static_cast<uint32_t>(getLittleEndian(p + 12, 4));
+		e.width = static_cast<uint32_t>(getLittleEndian(p + 16, 4));
+		e.height = static_cast<uint32_t>(getLittleEndian(p + 20, 4));
+		e.page = static_cast<uint32_t>(getLittleEndian(p + 24, 4));
+		e.x = static_cast<uint32_t>(getLittleEndian(p + 28, 4));
+		e.y = static_cast<uint32_t>(getLittleEndian(p + 32, 4));
+		e.offset = getLittleEndian(p + 40, 8);
+		e.size = getLittleEndian(p + 48, 8);
+		p += PACK_ENTRY_SIZE;
+
+		if (e.offset > m_size  ||  e.size > m_size - e.offset)
+			return false;
+		uint64_t expected = 0;
+		if (e.format == ASSET_FORMAT_BGRA8)
+			expected = static_cast<uint64_t>(e.width) * e.height * 4;
+		else if (e.format == ASSET_FORMAT_PCM16)
+			expected = static_cast<uint64_t>(e.width) * e.height * sizeof(int16_t);
+		if (e.size != expected  ||  (e.format == ASSET_FORMAT_PCM16  &&  e.height != AUDIO_CHANNELS))
+			return false;
+		if (e.format == ASSET_FORMAT_PCM16  &&  e.offset % sizeof(int16_t) != 0)
+			return false;
+		if ((e.kind == ASSET_ATLAS_PAGE  &&  e.format != ASSET_FORMAT_BGRA8)  ||
+			(e.kind == ASSET_SPRITE  &&  e.format != ASSET_FORMAT_NONE)  ||
+			(e.kind == ASSET_SOUND  &&  e.format != ASSET_FORMAT_PCM16))
+			return false;
+	}
+
+	  // Pages must be numbered from 0 with none missing or repeated, and
+	  // every sprite must lie wholly inside the page it says it's on.
+	vector<const AssetEntry*> pages;
+	for (const AssetEntry& e : m_entries)
+	{
+		if (e.kind == ASSET_ATLAS_PAGE)
+			pages.push_back(nullptr);
+	}
+	for (const AssetEntry& e : m_entries)
+	{
+		if (e.kind != ASSET_ATLAS_PAGE)
+			continue;
+		if (e.id >= pages.size()  ||  pages[e.id] != nullptr  ||
+			e.width == 0  ||  e.width > MAX_ATLAS_SIZE  ||  e.height == 0  ||  e.height > MAX_ATLAS_SIZE)
+			return false;
+		pages[e.id] = &e;
+	}
+	for (const AssetEntry& e : m_entries)
+	{
+		if (e.kind != ASSET_SPRITE)
+			continue;
+		if (e.page >= pages.size())
+			return false;
+		const AssetEntry& page = *pages[e.page];
+		if (static_cast<uint64_t>(e.x) + e.width > page.width  ||
+			static_cast<uint64_t>(e.y) + e.height > page.height)
+			return false;
+	}
+	return true;
+}
+
+const AssetEntry* AssetPack::find(AssetKind kind, int id, int frame) const
+{
+	for (const AssetEntry& e : m_entries)
+	{
+		if (e.kind == static_cast<uint32_t>(kind)  &&  e.id == static_cast<uint32_t>(id)  &&
+			e.frame == static_cast<uint32_t>(frame))
+			return &e;
+	}
+	return nullptr;
+}
@@ -0,0 +1,132 @@
+#ifndef ASSETPACK_H_
+#define ASSETPACK_H_
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+  // An asset pack holds every sprite and sound the game needs, already in
+  // the form they're used in, so that starting up is a matter of mapping
+  // one file and pointing OpenGL and the mixer at it.  All numbers are
+  // little-endian.
+  //
+  //   header:   "NBPK"  uint32 version  uint32 numEntries  uint32 reserved
+  //   entries:  numEntries of (uint32 kind, id, frame, format, width,
+  //             height, page, x, y, reserved; uint64 offset, size)
+  //   payloads: each starting on an ASSET_PACK_ALIGNMENT boundary, at the
+  //             offset from the start of the file its entry gives
+  //
+  // An ASSET_ATLAS_PAGE entry (id = page number) is a whole texture atlas
+  // of width x height BGRA pixels, sprites and gutters laid out by
+  // layOutAtlas just as loadAssets lays out the loose files.  An ASSET_SPRITE entry (id = image ID)
+  // has no payload; it says where in which page that frame of the image is.
+  // An ASSET_SOUND entry (id = sound ID) is the clip as 16-bit samples in
+  // the mixer's format: width frames of height channels each.
+
+const int ASSET_PACK_VERSION = 1;
+const int ASSET_PACK_ALIGNMENT = 4096;
+const char ASSET_PACK_FILE[] = "assets.nbpack";
+
+enum AssetKind { ASSET_ATLAS_PAGE = 1, ASSET_SPRITE = 2, ASSET_SOUND = 3 };
+enum AssetFormat { ASSET_FORMAT_NONE = 0, ASSET_FORMAT_BGRA8 = 1, ASSET_FORMAT_PCM16 = 2 };
+
+struct AssetEntry
+{
+	std::uint32_t kind;
+	std::uint32_t id;
+	std::uint32_t frame;
+	std::uint32_t format;
+	std::uint32_t width;
+	std::uint32_t height;
+	std::uint32_t page;
+	std::uint32_t x;
+	std::uint32_t y;
+	std::uint64_t offset;
+	std::uint64_t size;
+};
+
+  // The files the game's sprites and sounds are made from
+
+struct SpriteAsset
+{
+	int			imageID;
+	int			frameNum;
+	const char* tgaFileName;
+};
+
+struct SoundAsset
+{
+	int			soundID;
+	const char* wavFileName;
+};
+
+extern const SpriteAsset GAME_SPRITES[];
+extern const int NUM_GAME_SPRITES;
+extern const SoundAsset GAME_SOUNDS[];
+extern const int NUM_GAME_SOUNDS;
+
+  // Decode a TGA file (24-bit color, 32-bit color with alpha, or 8-bit
+  // greyscale; uncompressed or run length encoded) into BGRA pixels, bottom
+  // row first as OpenGL wants them.  Returns false if the file can't be read
+  // or is in some other format.
+bool decodeTga(const std::string& path, int& width, int& height, std::vector<char>& bgra);
+
+  // Build an asset pack at packPath from the game's loose files in
+  // assetDir.  On failure, returns false and says why in error.
+bool writeAssetPack(const std::string& assetDir, const std::string& packPath, std::string& error);
+
+  // An asset pack, mapped into memory read-only.  Payloads stay valid
+  // until the pack is closed or destroyed.
+
+class AssetPack
+{
+  public:
+	AssetPack();
+	~AssetPack();
+
+	  // Returns false if the file can't be read or isn't an asset pack,
+	  // including if its index contradicts itself: a payload the wrong size
+	  // for its entry, pages numbered other than 0 up with none missing, a
+	  // page bigger than MAX_ATLAS_SIZE, or a sprite that doesn't lie inside
+	  // its page.
+	bool open(const std::string& path);
+	void close();
+
+	bool isOpen() const
+	{
+		return m_base != nullptr;
+	}
+
+	const std::vector<AssetEntry>& entries() const
+	{
+		return m_entries;
+	}
+
+	  // The entry of that kind for that ID (and frame), or null
+	const AssetEntry* find(AssetKind kind, int id, int frame = 0) const;
+
+	const void* payload(const AssetEntry& e) const
+	{
+		return m_base + e.offset;
+	}
+
+	std::size_t mappedSize() const
+	{
+		return m_size;
+	}
+
+  private:
+	const unsigned char*	m_base;
+	std::size_t				m_size;
+	std::vector<unsigned char> m_buffer;	// the file's contents where it can't be mapped
+	std::vector<AssetEntry> m_entries;
+
+	bool readIndex();
+
+	  // Prevent copying or assigning AssetPacks
+	AssetPack(const AssetPack&) = delete;
+	AssetPack& operator=(const AssetPack&) = delete;
+};
+
+#endif // ASSETPACK_H_
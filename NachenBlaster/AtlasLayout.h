@@ -0,0 +1,124 @@
+#ifndef ATLASLAYOUT_H_
+#define ATLASLAYOUT_H_
+
+#include <vector>
+#include <algorithm>
+
+  // Where sprites go in texture atlases, worked out without OpenGL so that
+  // SpriteManager and the asset packer lay them out the same way.
+
+const int MAX_ATLAS_SIZE = 2048;
+  // Each sprite's edge pixels are repeated this far out around it, so
+  // filtering and the first few mipmap levels never pick up a neighbor.
+const int ATLAS_GUTTER = 16;
+  // Atlas pages get mipmaps down to this level and no further.  A texel of
+  // level L covers 2^L pixels each way, and bilinear filtering at a
+  // sprite's edge can blend in the texel beyond the one the edge is in, so
+  // level L stays clear of the neighbors only while 2^(L+1) <= ATLAS_GUTTER.
+  // (Deeper levels would have to mix sprites: the atlas is one texture.)
+const int ATLAS_MAX_MIP_LEVEL = 3;
+static_assert((2 << ATLAS_MAX_MIP_LEVEL) <= ATLAS_GUTTER, "atlas mipmaps would bleed between sprites");
+
+struct AtlasPlacement
+{
+	int page;
+	int x;	// of the image itself, inside its gutter
+	int y;
+};
+
+struct AtlasPageSize
+{
+	int width;
+	int height;
+};
+
+inline int roundUpToPowerOf2(int n)
+{
+	int p = 1;
+	while (p < n)
+		p *= 2;
+	return p;
+}
+
+  // Shelf packing: tallest first, left to right along a shelf as tall as
+  // its first sprite, a new shelf when a row fills up, and a new page when
+  // the shelves reach the top of an atlasSize square.  Pages stay
+  // power-of-two sized, as older GL needs.  Returns false if an image is
+  // too big for even an empty page.
+
+inline bool layOutAtlas(const std::vector<AtlasPageSize>& images, int atlasSize,
+						std::vector<AtlasPlacement>& placements, std::vector<AtlasPageSize>& pages)
+{
+	placements.assign(images.size(), AtlasPlacement());
+	pages.clear();
+
+	std::vector<int> order;
+	for (size_t k = 0; k < images.size(); k++)
+	{
+		if (images[k].width + 2*ATLAS_GUTTER > atlasSize  ||  images[k].height + 2*ATLAS_GUTTER > atlasSize)
+			return false;
+		order.push_back(static_cast<int>(k));
+	}
+	if (order.empty())
+		return true;
+	std::stable_sort(order.begin(), order.end(),
+		[&images](int a, int b) { return images[a].height > images[b].height; });
+
+	AtlasPageSize page = { 1, 0 };
+	int x = 0, shelfY = 0, shelfHeight = 0;
+	for (int k : order)
+	{
+		int w = images[k].width + 2*ATLAS_GUTTER;
+		int h = images[k].height + 2*ATLAS_GUTTER;
+		if (x + w > atlasSize)
+		{
+			shelfY += shelfHeight;
+			x = 0;
+			shelfHeight = 0;
+		}
+		if (shelfY + h > atlasSize)
+		{
+			pages.push_back(page);
+			page.width = 1;
+			page.height = 0;
+			x = shelfY = shelfHeight = 0;
+		}
+		AtlasPlacement& p = placements[k];
+		p.page = static_cast<int>(pages.size());
+		p.x = x + ATLAS_GUTTER;
+		p.y = shelfY + ATLAS_GUTTER;
+		x += w;
+		shelfHeight = std::max(shelfHeight, h);
+		page.width = std::max(page.width, x);
+		page.height = std::max(page.height, shelfY + shelfHeight);
+	}
+	pages.push_back(page);
+	for (AtlasPageSize& p : pages)
+	{
+		p.width = roundUpToPowerOf2(p.width);
+		p.height = roundUpToPowerOf2(p.height);
+	}
+	return true;
+}
+
+  // Copy a width x height BGRA image into a page at (x, y), then fill its
+  // gutter by repeating its outermost pixels.
+
+inline void blitWithGutter(const char* image, int width, int height,
+						   char* page, int pageWidth, int x, int y)
+{
+	for (int dy = -ATLAS_GUTTER; dy < height + ATLAS_GUTTER; dy++)
+	{
+		int sy = std::min(std::max(dy, 0), height - 1);
+		for (int dx = -ATLAS_GUTTER; dx < width + ATLAS_GUTTER; dx++)
+		{
+			int sx = std::min(std::max(dx, 0), width - 1);
+			const char* from = &image[4 * (sy * width + sx)];
+			char* to = &page[4 * ((y + dy) * pageWidth + x + dx)];
+			for (int c = 0; c < 4; c++)
+				to[c] = from[c];
+		}
+	}
+}
+
+#endif // ATLASLAYOUT_H_
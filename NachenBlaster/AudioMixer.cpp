@@ -0,0 +1,430 @@
+#include "AudioMixer.h"
+#include "GameConstants.h"
+#include <chrono>
+#include <iterator>
+#include <algorithm>
+#include <cstring>
+#if defined(NB_USE_ALSA)
+#include <alsa/asoundlib.h>
+#endif
+using namespace std;
+
+static const int WAV_FORMAT_PCM = 1;
+static const int WAV_FORMAT_EXTENSIBLE = 0xfffe;
+
+static uint32_t getLittleEndian(const unsigned char* p, int n)
+{
+	uint32_t v = 0;
+	for (int k = 0; k < n; k++)
+		v |= static_cast<uint32_t>(p[k]) << (8 * k);
+	return v;
+}
+
+static void putLittleEndian(unsigned char* p, uint32_t v, int n)
+{
+	for (int k = 0; k < n; k++)
+		p[k] = static_cast<unsigned char>(v >> (8 * k));
+}
+
+bool decodeWav(const string& path, PcmClip& clip)
+{
+	ifstream file(path, ios::in | ios::binary);
+	if (!file)
+		return false;
+	vector<unsigned char> data((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+	if (data.size() < 12  ||  memcmp(&data[0], "RIFF", 4) != 0  ||  memcmp(&data[8], "WAVE", 4) != 0)
+		return false;
+
+	int format = 0;
+	int channels = 0;
+	int sampleRate = 0;
+	int bitsPerSample = 0;
+	const unsigned char* samples = nullptr;
+	size_t sampleBytes = 0;
+	for (size_t pos = 12; pos + 8 <= data.size(); )
+	{
+		const unsigned char* chunk = &data[pos];
+		size_t size = getLittleEndian(chunk + 4, 4);
+		size_t available = min(size, data.size() - pos - 8);
+		if (memcmp(chunk, "fmt ", 4) == 0  &&  available >= 16)
+		{
+			format = getLittleEndian(chunk + 8, 2);
+			channels = getLittleEndian(chunk + 10, 2);
+			sampleRate = getLittleEndian(chunk + 12, 4);
+			bitsPerSample = getLittleEndian(chunk + 22, 2);
+			if (format == WAV_FORMAT_EXTENSIBLE  &&  available >= 26)
+				format = getLittleEndian(chunk + 32, 2);  // start of the subformat GUID
+		}
+		else if (memcmp(chunk, "data", 4) == 0)
+		{
+			samples = chunk + 8;
+			sampleBytes = available;
+		}
+		pos += 8 + size + (size & 1);  // chunks are padded to an even size
+	}
+	if (format != WAV_FORMAT_PCM  ||  channels < 1  ||  channels > 2  ||  sampleRate <= 0  ||
+		(bitsPerSample != 8  &&  bitsPerSample != 16)  ||  samples == nullptr)
+		return false;
+
+	  // To 16-bit stereo at the file's rate...
+	int bytesPerFrame = channels * bitsPerSample / 8;
+	size_t numFrames = sampleBytes / bytesPerFrame;
+	vector<int16_t> stereo(numFrames * AUDIO_CHANNELS);
+	for (size_t f = 0; f < numFrames; f++)
+	{
+		const unsigned char* p = samples + f * bytesPerFrame;
+		int16_t s[2];
+		for (int c = 0; c < channels; c++)
+		{
+			if (bitsPerSample == 8)
+				s[c] = static_cast<int16_t>((p[c] - 128) * 256);
+			else
+				s[c] = static_cast<int16_t>(getLittleEndian(p + 2 * c, 2));
+		}
+		stereo[2 * f] = s[0];
+		stereo[2 * f + 1] = s[channels - 1];
+	}
+
+	  // ...then to the mixing rate, interpolating linearly
+	if (sampleRate == AUDIO_SAMPLE_RATE)
+	{
+		clip.samples.swap(stereo);
+		return true;
+	}
+	size_t outFrames = static_cast<size_t>(static_cast<long long>(numFrames) * AUDIO_SAMPLE_RATE / sampleRate);
+	clip.samples.assign(outFrames * AUDIO_CHANNELS, 0);
+	for (size_t f = 0; f < outFrames; f++)
+	{
+		double srcPos = static_cast<double>(f) * sampleRate / AUDIO_SAMPLE_RATE;
+		size_t i0 = static_cast<size_t>(srcPos);
+		size_t i1 = min(i0 + 1, numFrames - 1);
+		double frac = srcPos - i0;
+		for (int c = 0; c < AUDIO_CHANNELS; c++)
+		{
+			double v = stereo[2 * i0 + c] * (1 - frac) + stereo[2 * i1 + c] * frac;
+			clip.samples[2 * f + c] = static_cast<int16_t>(v);
+		}
+	}
+	return true;
+}
+
+static const int WAV_HEADER_SIZE = 44;
+
+WavFileSink::WavFileSink(const string& path)
+ : m_file(path, ios::out | ios::binary | ios::trunc), m_framesWritten(0)
+{
+	if (!m_file)
+		return;
+	unsigned char header[WAV_HEADER_SIZE];
+	memcpy(header, "RIFF", 4);
+	putLittleEndian(header + 4, WAV_HEADER_SIZE - 8, 4);	// sizes are filled in at the end
+	memcpy(header + 8, "WAVEfmt ", 8);
+	putLittleEndian(header + 16, 16, 4);
+	putLittleEndian(header + 20, WAV_FORMAT_PCM, 2);
+	putLittleEndian(header + 22, AUDIO_CHANNELS, 2);
+	putLittleEndian(header + 24, AUDIO_SAMPLE_RATE, 4);
+	putLittleEndian(header + 28, AUDIO_SAMPLE_RATE * AUDIO_CHANNELS * 2, 4);
+	putLittleEndian(header + 32, AUDIO_CHANNELS * 2, 2);
+	putLittleEndian(header + 34, 16, 2);
+	memcpy(header + 36, "data", 4);
+	putLittleEndian(header + 40, 0, 4);
+	m_file.write(reinterpret_cast<const char*>(header), WAV_HEADER_SIZE);
+}
+
+WavFileSink::~WavFileSink()
+{
+	if (!m_file.is_open())
+		return;
+	uint32_t dataBytes = static_cast<uint32_t>(m_framesWritten * AUDIO_CHANNELS * 2);
+	unsigned char size[4];
+	putLittleEndian(size, WAV_HEADER_SIZE - 8 + dataBytes, 4);
+	m_file.seekp(4);
+	m_file.write(reinterpret_cast<const char*>(size), 4);
+	putLittleEndian(size, dataBytes, 4);
+	m_file.seekp(40);
+	m_file.write(reinterpret_cast<const char*>(size), 4);
+}
+
+void WavFileSink::write(const int16_t* frames, int numFrames)
+{
+	if (!m_file.is_open())
+		return;
+	size_t numSamples = static_cast<size_t>(numFrames) * AUDIO_CHANNELS;
+	m_bytes.resize(numSamples * 2);
+	for (size_t k = 0; k < numSamples; k++)
+		putLittleEndian(&m_bytes[2 * k], static_cast<uint16_t>(frames[k]), 2);
+	m_file.write(reinterpret_cast<const char*>(m_bytes.data()), m_bytes.size());
+	m_framesWritten += numFrames;
+}
+
+#if defined(NB_USE_ALSA)
+
+AlsaAudioSink::AlsaAudioSink()
+ : m_pcm(nullptr)
+{
+	snd_pcm_t* pcm;
+	if (snd_pcm_open(&pcm, "default", SND_PCM_STREAM_PLAYBACK, 0) < 0)
+		return;
+	const unsigned int LATENCY_US = 50000;
+	if (snd_pcm_set_params(pcm, SND_PCM_FORMAT_S16_LE, SND_PCM_ACCESS_RW_INTERLEAVED,
+						   AUDIO_CHANNELS, AUDIO_SAMPLE_RATE, 1, LATENCY_US) < 0)
+	{
+		snd_pcm_close(pcm);
+		return;
+	}
+	m_pcm = pcm;
+}
+
+AlsaAudioSink::~AlsaAudioSink()
+{
+	if (m_pcm != nullptr)
+	{
+		snd_pcm_drop(m_pcm);
+		snd_pcm_close(m_pcm);
+	}
+}
+
+void AlsaAudioSink::write(const int16_t* frames, int numFrames)
+{
+	while (m_pcm != nullptr  &&  numFrames > 0)
+	{
+		snd_pcm_sframes_t n = snd_pcm_writei(m_pcm, frames, numFrames);
+		if (n < 0)
+		{
+			  // an underrun, most likely; start over if possible
+			if (snd_pcm_recover(m_pcm, static_cast<int>(n), 1) < 0)
+				return;
+			continue;
+		}
+		frames += n * AUDIO_CHANNELS;
+		numFrames -= static_cast<int>(n);
+	}
+}
+
+#endif // NB_USE_ALSA
+
+AudioMixer::AudioMixer(AudioSink* sink, AudioMixerListener* listener)
+ : m_sink(sink), m_listener(listener), m_voicesStarted(0), m_soundsDropped(0),
+   m_accumulator(FRAMES_PER_PERIOD * AUDIO_CHANNELS),
+   m_output(FRAMES_PER_PERIOD * AUDIO_CHANNELS), m_running(false)
+{
+	for (Voice& v : m_voices)
+	{
+		v.clip = nullptr;
+		v.position = 0;
+		v.startOrder = 0;
+		v.soundID = SOUND_NONE;
+		v.priority = 0;
+	}
+}
+
+AudioMixer::~AudioMixer()
+{
+	stop();
+}
+
+bool AudioMixer::loadClip(int soundID, const string& wavPath)
+{
+	PcmClip clip;
+	if (!decodeWav(wavPath, clip))
+		return false;
+	PcmClip& c = m_clips[soundID];
+	c.samples.swap(clip.samples);
+	c.mapped = nullptr;
+	return true;
+}
+
+void AudioMixer::addClip(int soundID, PcmClip clip)
+{
+	m_clips[soundID] = move(clip);
+}
+
+void AudioMixer::addMappedClip(int soundID, const int16_t* samples, size_t numFrames)
+{
+	PcmClip& c = m_clips[soundID];
+	c.samples.clear();
+	c.mapped = samples;
+	c.mappedFrames = numFrames;
+}
+
+void AudioMixer::start()
+{
+	if (m_running)
+		return;
+	m_running = true;
+	m_thread = thread(&AudioMixer::threadLoop, this);
+}
+
+void AudioMixer::stop()
+{
+	if (!m_running)
+		return;
+	m_running = false;
+	m_thread.join();
+}
+
+void AudioMixer::play(int soundID)
+{
+	Command c;
+	c.stopFirst = false;
+	c.numSounds = 1;
+	c.soundIDs[0] = soundID;
+	m_commands.push(c);
+}
+
+void AudioMixer::stopAll()
+{
+	Command c;
+	c.stopFirst = true;
+	c.numSounds = 0;
+	m_commands.push(c);
+}
+
+void AudioMixer::playSound(int soundID)
+{
+	if (soundID == SOUND_NONE)
+		stopAll();
+	else
+		play(soundID);
+}
+
+void AudioMixer::playSounds(const SoundBatch& batch)
+{
+	Command c;
+	c.stopFirst = batch.stopsFirst();
+	c.numSounds = batch.size();
+	for (int k = 0; k < batch.size(); k++)
+		c.soundIDs[k] = batch.soundID(k);
+	m_commands.push(c);
+}
+
+void AudioMixer::mix(int numFrames)
+{
+	runCommands();
+	while (numFrames > 0)
+	{
+		int n = min(numFrames, static_cast<int>(FRAMES_PER_PERIOD));
+		mixPeriod(n);
+		numFrames -= n;
+	}
+}
+
+void AudioMixer::runCommands()
+{
+	Command c;
+	while (m_commands.pop(c))
+	{
+		if (c.stopFirst)
+			stopAllVoices();
+		for (int k = 0; k < c.numSounds; k++)
+		{
+			if (startVoice(c.soundIDs[k])  &&  m_listener != nullptr)
+				m_listener->clipStarted(c.soundIDs[k]);
+		}
+	}
+}
+
+void AudioMixer::stopAllVoices()
+{
+	for (Voice& v : m_voices)
+		v.clip = nullptr;
+	if (m_listener != nullptr)
+		m_listener->allClipsStopped();
+}
+
+  // If the sound is already playing as often as its policy allows, restart
+  // its oldest copy.  Otherwise use a free voice, or else cut off the oldest
+  // of the least important voices, unless even that one matters more.
+
+bool AudioMixer::startVoice(int soundID)
+{
+	map<int, PcmClip>::const_iterator p = m_clips.find(soundID);
+	if (p == m_clips.end()  ||  p->second.numFrames() == 0)
+		return false;
+	SoundPolicy policy = { 0, MAX_VOICES };
+	if (soundID >= 0  &&  soundID < NUM_SOUNDS)
+		policy = soundPolicy(soundID);
+
+	int copies = 0;
+	Voice* oldestCopy = nullptr;
+	Voice* freeVoice = nullptr;
+	Voice* victim = nullptr;
+	for (Voice& v : m_voices)
+	{
+		if (v.clip == nullptr)
+		{
+			if (freeVoice == nullptr)
+				freeVoice = &v;
+			continue;
+		}
+		if (v.soundID == soundID)
+		{
+			copies++;
+			if (oldestCopy == nullptr  ||  v.startOrder < oldestCopy->startOrder)
+				oldestCopy = &v;
+		}
+		if (victim == nullptr  ||  v.priority < victim->priority  ||
+			(v.priority == victim->priority  &&  v.startOrder < victim->startOrder))
+			victim = &v;
+	}
+
+	Voice* chosen;
+	if (copies >= policy.maxVoices)
+		chosen = oldestCopy;
+	else if (freeVoice != nullptr)
+		chosen = freeVoice;
+	else if (victim->priority <= policy.priority)
+		chosen = victim;
+	else
+	{
+		m_soundsDropped++;
+		return false;
+	}
+	chosen->clip = &p->second;
+	chosen->position = 0;
+	chosen->startOrder = m_voicesStarted++;
+	chosen->soundID = soundID;
+	chosen->priority = policy.priority;
+	return true;
+}
+
+void AudioMixer::mixPeriod(int numFrames)
+{
+	int numSamples = numFrames * AUDIO_CHANNELS;
+	fill(m_accumulator.begin(), m_accumulator.begin() + numSamples, 0);
+	for (Voice& v : m_voices)
+	{
+		if (v.clip == nullptr)
+			continue;
+		size_t frames = min(static_cast<size_t>(numFrames), v.clip->numFrames() - v.position);
+		const int16_t* src = v.clip->data() + v.position * AUDIO_CHANNELS;
+		for (size_t k = 0; k < frames * AUDIO_CHANNELS; k++)
+			m_accumulator[k] += src[k];
+		v.position += frames;
+		if (v.position == v.clip->numFrames())
+			v.clip = nullptr;
+	}
+	for (int k = 0; k < numSamples; k++)
+		m_output[k] = static_cast<int16_t>(max(-32768, min(32767, m_accumulator[k])));
+	m_sink->write(m_output.data(), numFrames);
+}
+
+void AudioMixer::threadLoop()
+{
+	const chrono::nanoseconds period(1000000000LL * FRAMES_PER_PERIOD / AUDIO_SAMPLE_RATE);
+	chrono::steady_clock::time_point nextPeriod = chrono::steady_clock::now();
+	while (m_running)
+	{
+		runCommands();
+		mixPeriod(FRAMES_PER_PERIOD);
+		if (!m_sink->pacesItself())
+		{
+			nextPeriod += period;
+			chrono::steady_clock::time_point now = chrono::steady_clock::now();
+			if (now - nextPeriod > 10 * period)
+				nextPeriod = now;  // fell far behind; don't race to catch up
+			this_thread::sleep_until(nextPeriod);
+		}
+	}
+	runCommands();  // e.g., the stopAll that came with quitting
+}
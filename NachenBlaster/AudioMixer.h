@@ -0,0 +1,257 @@
+#ifndef AUDIOMIXER_H_
+#define AUDIOMIXER_H_
+
+#include "GameHost.h"
+#include "SpscQueue.h"
+#include <string>
+#include <vector>
+#include <map>
+#include <fstream>
+#include <thread>
+#include <atomic>
+#include <cstdint>
+
+  // Everything is mixed as interleaved 16-bit stereo at one rate; clips are
+  // converted to it when they're loaded.
+
+const int AUDIO_SAMPLE_RATE = 44100;
+const int AUDIO_CHANNELS = 2;
+
+  // A decoded sound, ready to mix.  Its samples are its own, or, if mapped
+  // is set, somewhere else that outlives it (e.g., an AssetPack).
+
+struct PcmClip
+{
+	std::vector<std::int16_t> samples;	// interleaved, AUDIO_CHANNELS per frame
+	const std::int16_t*		  mapped;
+	std::size_t				  mappedFrames;
+
+	PcmClip()
+	 : mapped(nullptr), mappedFrames(0)
+	{
+	}
+
+	const std::int16_t* data() const
+	{
+		return mapped != nullptr ? mapped : samples.data();
+	}
+
+	std::size_t numFrames() const
+	{
+		return mapped != nullptr ? mappedFrames : samples.size() / AUDIO_CHANNELS;
+	}
+};
+
+  // Decode a PCM WAV file (8 or 16 bits, mono or stereo, any rate) into
+  // clip, converting it to the mixing format.  Returns false if the file
+  // can't be read or is in some other format.
+bool decodeWav(const std::string& path, PcmClip& clip);
+
+  // Where mixed audio goes.  write is called on the mixing thread only.
+
+class AudioSink
+{
+  public:
+	virtual ~AudioSink()
+	{
+	}
+
+	virtual void write(const std::int16_t* frames, int numFrames) = 0;
+
+	  // Does write wait until the device wants more, so that the mixer
+	  // needn't keep time itself?
+	virtual bool pacesItself() const
+	{
+		return false;
+	}
+};
+
+  // Throws the audio away, counting it
+
+class NullAudioSink : public AudioSink
+{
+  public:
+	NullAudioSink()
+	 : m_framesWritten(0)
+	{
+	}
+
+	virtual void write(const std::int16_t*, int numFrames)
+	{
+		m_framesWritten += numFrames;
+	}
+
+	long long framesWritten() const
+	{
+		return m_framesWritten;
+	}
+
+  private:
+	long long m_framesWritten;
+};
+
+  // Writes the audio to a WAV file, whose header is completed when the sink
+  // is destroyed
+
+class WavFileSink : public AudioSink
+{
+  public:
+	WavFileSink(const std::string& path);
+	virtual ~WavFileSink();
+
+	bool isOpen() const
+	{
+		return m_file.is_open();
+	}
+
+	virtual void write(const std::int16_t* frames, int numFrames);
+
+  private:
+	std::ofstream m_file;
+	long long	  m_framesWritten;
+	std::vector<unsigned char> m_bytes;
+};
+
+#if defined(NB_USE_ALSA)
+
+  // Plays the audio on the default ALSA device.  Build with -DNB_USE_ALSA
+  // and link with -lasound to get it.
+
+typedef struct _snd_pcm snd_pcm_t;
+
+class AlsaAudioSink : public AudioSink
+{
+  public:
+	AlsaAudioSink();
+	virtual ~AlsaAudioSink();
+
+	bool isOpen() const
+	{
+		return m_pcm != nullptr;
+	}
+
+	virtual void write(const std::int16_t* frames, int numFrames);
+
+	virtual bool pacesItself() const
+	{
+		return true;
+	}
+
+  private:
+	snd_pcm_t* m_pcm;
+};
+
+#endif // NB_USE_ALSA
+
+  // Told about every command the mixer carries out, on the mixing thread.
+  // This is how platforms whose sound still goes through SoundFXController
+  // hear anything.
+
+class AudioMixerListener
+{
+  public:
+	virtual ~AudioMixerListener()
+	{
+	}
+
+	virtual void clipStarted(int soundID) = 0;
+	virtual void allClipsStopped() = 0;
+};
+
+  // Mixes up to MAX_VOICES clips at once into an AudioSink on a thread of
+  // its own.  Clips are decoded up front; after that, playing one (or a
+  // tick's batch) just puts a command in a lock-free queue, with no
+  // allocation, system call or lock, so it's safe to do from the tick loop.
+  // Only one thread may give commands.  Which voice a sound gets follows
+  // its SoundPolicy.
+  //
+  // Without start, nothing happens until mix is called, which mixes on the
+  // calling thread instead (for rendering a game's sound offline).
+
+class AudioMixer : public SoundSink
+{
+  public:
+	static const int MAX_VOICES = 16;
+	static const int FRAMES_PER_PERIOD = 512;	// mixed at a time, about 12 ms
+
+	AudioMixer(AudioSink* sink, AudioMixerListener* listener = nullptr);
+	virtual ~AudioMixer();
+
+	  // Clips can only be added before start.
+	bool loadClip(int soundID, const std::string& wavPath);
+	void addClip(int soundID, PcmClip clip);
+	  // Play numFrames of samples in place; they must outlive the mixer.
+	void addMappedClip(int soundID, const std::int16_t* samples, std::size_t numFrames);
+
+	void start();
+	  // Carry out any commands still queued, then stop the mixing thread.
+	void stop();
+
+	  // Commands.  If the queue is full, the command is dropped.
+	void play(int soundID);
+	void stopAll();
+
+	  // SOUND_NONE stops everything; anything else plays that clip.
+	virtual void playSound(int soundID);
+
+	  // One command for the whole batch
+	virtual void playSounds(const SoundBatch& batch);
+
+	  // Carry out the queued commands and mix numFrames into the sink.  Use
+	  // this only if the mixer hasn't been started.
+	void mix(int numFrames);
+
+	  // Total number of voices ever started
+	long long voicesStarted() const
+	{
+		return m_voicesStarted;
+	}
+
+	  // Sounds not played because every voice had something more important
+	long long soundsDropped() const
+	{
+		return m_soundsDropped;
+	}
+
+  private:
+	  // Stop everything first if asked, then start each sound in order
+	struct Command
+	{
+		bool	stopFirst;
+		int		numSounds;
+		int		soundIDs[NUM_SOUNDS];
+	};
+
+	struct Voice
+	{
+		const PcmClip* clip;	// null if the voice is free
+		std::size_t	   position;	// next frame to play
+		long long	   startOrder;	// when it started, to find the oldest
+		int			   soundID;
+		int			   priority;
+	};
+
+	AudioSink*			 m_sink;
+	AudioMixerListener*	 m_listener;
+	std::map<int, PcmClip> m_clips;
+	SpscQueue<Command, 1024> m_commands;
+	Voice				 m_voices[MAX_VOICES];
+	long long			 m_voicesStarted;
+	long long			 m_soundsDropped;
+	std::vector<std::int32_t> m_accumulator;
+	std::vector<std::int16_t> m_output;
+	std::thread			 m_thread;
+	std::atomic<bool>	 m_running;
+
+	void runCommands();
+	void stopAllVoices();
+	bool startVoice(int soundID);
+	void mixPeriod(int numFrames);
+	void threadLoop();
+
+	  // Prevent copying or assigning AudioMixers
+	AudioMixer(const AudioMixer&) = delete;
+	AudioMixer& operator=(const AudioMixer&) = delete;
+};
+
+#endif // AUDIOMIXER_H_
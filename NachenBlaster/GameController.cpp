@@ -5,11 +5,14 @@
 #include "GraphObject.h"
 #include "SoundFX.h"
 #include "SpriteManager.h"
+#include "SpriteMath.h"
 #include <string>
 #include <map>
 #include <utility>
 #include <cstdlib>
 #include <algorithm>
+#include <thread>
+#include <chrono>
 using namespace std;
 
 /*
@@ -41,86 +44,178 @@ static const double FONT_SCALEDOWN = 760.0;
 static const double SCORE_Y = 3.8;
 static const double SCORE_Z = -10;
 
-static const int MS_PER_FRAME = 5;
+static const int MS_PER_FRAME = 5;		// how often the window is redrawn
+static const int MS_PER_TICK = 15;		// how often the game moves, by default
+static const int MAX_MS_BEHIND = 250;	// after falling this far behind, give up catching up
 
-static void drawPrompt(string mainMessage, string secondMessage);
-static void drawScoreAndLives(string);
+static void drawPrompt(const StrokeText& mainMessage, const StrokeText& secondMessage);
+static void drawScoreAndLives(const StrokeText& gameStatText, RandomGenerator& flicker, float rgb[3]);
 
 enum GameController::GameControllerState : int {
-	welcome, init, makemove, animate, contgame, finishedlevel, cleanup, gameover, prompt, quit, not_applicable
+	welcome, startlevel, makemove, singlestep, contgame, finishedlevel, gameover, prompt, quit
 };
 
+GameController::GameController()
+ : m_gw(nullptr), m_gameState(welcome), m_nextStateAfterPrompt(welcome),
+   m_heldKeys(0), m_singleStep(false), m_quitRequested(false),
+   m_simulationDone(false), m_msPerTick(MS_PER_TICK), m_playerWon(false),
+   m_spriteLoadMs(0), m_spritesLoaded(false), m_spritesUploaded(false),
+   m_preparedStatus(GWSTATUS_CONTINUE_GAME), m_levelPrepared(false), m_background(1)
+{
+	for (int k = 0; k < 3; k++)
+		m_statTextColor[k] = .6f;
+}
+
+  // Take the sprites and sounds from the asset pack if there is one, or
+  // else from the loose files.  The sounds are needed now, for the welcome
+  // theme; the sprites aren't needed until play starts, so their decoding
+  // and mipmapping go on in the background, leaving only the uploads for
+  // the GLUT thread.  The loose WAV files are still where
+  // SoundFXController plays from.
+
 void GameController::initDrawersAndSounds()
 {
-	struct SpriteInfo
+	string path = m_gw->assetDirectory();
+	if (!path.empty())
+		path += '/';
+
+	m_assetPack.open(path + ASSET_PACK_FILE);
+	vector<LoadedSound> sounds;
+	loadSounds(m_gw->assetDirectory(), &m_assetPack, m_loaderPool, sounds);
+	for (LoadedSound& s : sounds)
 	{
-		int imageID;
-		int frameNum;
-		std::string tgaFileName;
-	};
-
-	SpriteInfo drawers[] = {
-		{ IID_NACHENBLASTER , 0, "ship.tga"},
-		{ IID_SMALLGON, 0, "smallgon.tga" },
-		{ IID_SMOREGON, 0, "smoregon.tga" },
-		{ IID_SNAGGLEGON, 0, "snagglegon.tga" },
-		{ IID_REPAIR_GOODIE, 0, "health.tga" },
-		{ IID_LIFE_GOODIE, 0, "life.tga" },
-		{ IID_TORPEDO_GOODIE, 0, "sonar.tga" },
-		{ IID_TORPEDO, 0, "torpedo.tga" },
-		{ IID_TURNIP, 0, "turnip.tga" },
-		{ IID_CABBAGE, 0, "cabbage.tga"},
-		{ IID_STAR, 0, "star1.tga" },
-		{ IID_EXPLOSION, 0, "explosion.tga" },
-	};
-
-	SoundMapType::value_type sounds[] = {
-		make_pair(SOUND_THEME          , "theme.wav"),
-		make_pair(SOUND_GOODIE         , "goodie.wav"),
-		make_pair(SOUND_BLAST          , "ouch.wav"),
-		make_pair(SOUND_PLAYER_SHOOT   , "laser.wav"),
-		make_pair(SOUND_ALIEN_SHOOT    , "laser2.wav"),
-		make_pair(SOUND_FINISHED_LEVEL , "finished.wav"),
-		make_pair(SOUND_DEATH          , "blowup.wav"),
-		make_pair(SOUND_TORPEDO        , "torpedo.wav"),
-	};
-
-	for (int k = 0; k < sizeof(drawers)/sizeof(drawers[0]); k++)
+		if (s.clip.mapped != nullptr)
+			m_mixer->addMappedClip(s.soundID, s.clip.mapped, s.clip.mappedFrames);
+		else
+			m_mixer->addClip(s.soundID, move(s.clip));
+	}
+	m_font.init();
+	for (int k = 0; k < NUM_GAME_SOUNDS; k++)
+		m_soundMap[GAME_SOUNDS[k].soundID] = path + GAME_SOUNDS[k].wavFileName;
+
+	int atlasSize = SpriteManager::maxAtlasSize();
+	bool mipmapped = m_spriteManager.mipMapping();
+	m_background.submit([this, atlasSize, mipmapped] { loadSprites(atlasSize, mipmapped); });
+}
+
+  // Called on the background thread.  If the pack's atlas is too big for
+  // this OpenGL, fall back to the loose files (the pack stays open; the
+  // mixer may be playing from it).
+
+void GameController::loadSprites(int atlasSize, bool mipmapped)
+{
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	m_spriteSource = ASSET_PACK_FILE;
+	if (!m_assetPack.isOpen()  ||
+		!::loadSprites(m_gw->assetDirectory(), &m_assetPack, atlasSize, mipmapped,
+					   m_loaderPool, m_loadedSprites, m_spriteLoadError))
 	{
-		string path = m_gw->assetDirectory();
-		if (!path.empty())
-			path += '/';
-		const SpriteInfo& d = drawers[k];
-		if (!m_spriteManager.loadSprite(path + d.tgaFileName, d.imageID, d.frameNum))
-			exit(1);
+		m_spriteSource = "loose files";
+		m_spriteLoadError.clear();
+		::loadSprites(m_gw->assetDirectory(), nullptr, atlasSize, mipmapped,
+					  m_loaderPool, m_loadedSprites, m_spriteLoadError);
 	}
-	for (int k = 0; k < sizeof(sounds)/sizeof(sounds[0]); k++)
-		m_soundMap[sounds[k].first] = sounds[k].second;
+	chrono::duration<double, milli> elapsed = chrono::steady_clock::now() - start;
+	m_spriteLoadMs = elapsed.count();
+	m_spritesLoaded = true;
 }
 
-static void doSomethingCallback()
+void GameController::uploadSprites()
 {
-	Game().doSomething();
+	if (!m_spriteLoadError.empty())
+	{
+		cout << m_spriteLoadError << endl;
+		m_quitRequested = true;
+		return;
+	}
+	m_spriteManager.addLoadedAssets(m_loadedSprites);
+	m_loadedSprites = LoadedAssets();
+	m_spritesUploaded = true;
+	cout << "Sprites loaded from " << m_spriteSource << " by " << m_loaderPool.numThreads()
+		 << " threads in " << m_spriteLoadMs << " ms, in the background" << endl;
+}
+
+  // Clean up after the level just played (if any) and initialize the next
+  // one while the player reads the prompt.  Nothing else touches the world
+  // until startlevel sees m_levelPrepared.
+
+void GameController::prepareLevel(bool cleanUpFirst)
+{
+	m_levelPrepared = false;
+	m_background.submit([this, cleanUpFirst] {
+		if (cleanUpFirst)
+			m_gw->cleanUp();
+		m_preparedStatus = m_gw->init();
+		m_levelPrepared = true;
+	});
+}
+
+void GameController::createMixer()
+{
+	if (!m_audioOutputPath.empty())
+	{
+		WavFileSink* sink = new WavFileSink(m_audioOutputPath);
+		if (!sink->isOpen())
+			cout << "Cannot create " << m_audioOutputPath << endl;
+		m_audioSink.reset(sink);
+	}
+#if defined(NB_USE_ALSA)
+	else
+	{
+		AlsaAudioSink* sink = new AlsaAudioSink;
+		if (sink->isOpen())
+			m_audioSink.reset(sink);
+		else
+			delete sink;
+	}
+#endif
+	if (m_audioSink == nullptr)
+		m_audioSink.reset(new NullAudioSink);
+	m_mixer.reset(new AudioMixer(m_audioSink.get(), this));
+}
+
+  // GLUT callbacks find their controller through the window's user data.
+  // (The timer isn't tied to a window, but there is only one, and it's
+  // always the current one.)
+
+static GameController& windowController()
+{
+	return *static_cast<GameController*>(glutGetWindowData());
+}
+
+static void displayCallback()
+{
+	windowController().display();
 }
 
 static void reshapeCallback(int w, int h)
 {
-	Game().reshape(w, h);
+	windowController().reshape(w, h);
 }
 
 static void keyboardEventCallback(unsigned char key, int x, int y)
 {
-	Game().keyboardEvent(key, x, y);
+	windowController().keyboardEvent(key, x, y);
+}
+
+static void keyboardUpEventCallback(unsigned char key, int x, int y)
+{
+	windowController().keyboardUpEvent(key, x, y);
 }
 
 static void specialKeyboardEventCallback(int key, int x, int y)
 {
-	Game().specialKeyboardEvent(key, x, y);
+	windowController().specialKeyboardEvent(key, x, y);
+}
+
+static void specialKeyboardUpEventCallback(int key, int x, int y)
+{
+	windowController().specialKeyboardUpEvent(key, x, y);
 }
 
 static void timerFuncCallback(int)
 {
-	Game().doSomething();
+	windowController().refresh();
 	glutTimerFunc(MS_PER_FRAME, timerFuncCallback, 0);
 }
 
@@ -128,11 +223,16 @@ void GameController::run(int argc, char* argv[], GameWorld* gw, string windowTit
 {
 	gw->setController(this);
 	m_gw = gw;
-	setGameState(welcome);
-	m_lastKeyHit = INVALID_KEY;
+	m_gameState = welcome;
+	m_heldKeys = 0;
 	m_singleStep = false;
-	m_curIntraFrameTick = 0;
+	m_quitRequested = false;
+	m_simulationDone = false;
 	m_playerWon = false;
+	m_spritesLoaded = false;
+	m_spritesUploaded = false;
+	m_levelPrepared = false;
+	m_flicker.reseed(gw->randomSeed(), RNG_HUD);
 
 	glutInit(&argc, argv);
 
@@ -140,64 +240,157 @@ void GameController::run(int argc, char* argv[], GameWorld* gw, string windowTit
 	glutInitWindowSize(WINDOW_WIDTH, WINDOW_HEIGHT);
 	glutInitWindowPosition(0, 0);
 	glutCreateWindow(windowTitle.c_str());
+	glutSetWindowData(this);
 
+	createMixer();
 	initDrawersAndSounds();
+	m_mixer->start();
 
+	glutIgnoreKeyRepeat(1);  // held keys are tracked instead
 	glutKeyboardFunc(keyboardEventCallback);
+	glutKeyboardUpFunc(keyboardUpEventCallback);
 	glutSpecialFunc(specialKeyboardEventCallback);
+	glutSpecialUpFunc(specialKeyboardUpEventCallback);
 	glutReshapeFunc(reshapeCallback);
-	glutDisplayFunc(doSomethingCallback);
+	glutDisplayFunc(displayCallback);
 	glutTimerFunc(MS_PER_FRAME, timerFuncCallback, 0);
 
 	glutSetOption(GLUT_ACTION_ON_WINDOW_CLOSE, GLUT_ACTION_GLUTMAINLOOP_RETURNS);
+	thread simulation(&GameController::runSimulation, this);
 	glutMainLoop();
+
+	  // The loop also returns if the window was closed, with the game still
+	  // running.
+	m_quitRequested = true;
+	simulation.join();
+	m_background.wait();
+	m_mixer->stop();
+	if (m_keyToScreen.count() > 0)
+		m_keyToScreen.print(cout, "Key press to screen latency");
 	delete m_gw;
 }
 
+  // Both cases of the letters, so that a key still comes up if shift
+  // changed while it was down
+
+static int gameKey(unsigned char key)
+{
+	switch (key)
+	{
+		case 'a': case 'A': case '4': return KEY_PRESS_LEFT;
+		case 'd': case 'D': case '6': return KEY_PRESS_RIGHT;
+		case 'w': case 'W': case '8': return KEY_PRESS_UP;
+		case 's': case 'S': case '2': return KEY_PRESS_DOWN;
+		case 't': case 'T':			  return KEY_PRESS_TAB;
+		default:					  return key;
+	}
+}
+
+static int gameSpecialKey(int key)
+{
+	switch (key)
+	{
+		case GLUT_KEY_LEFT:	 return KEY_PRESS_LEFT;
+		case GLUT_KEY_RIGHT: return KEY_PRESS_RIGHT;
+		case GLUT_KEY_UP:	 return KEY_PRESS_UP;
+		case GLUT_KEY_DOWN:	 return KEY_PRESS_DOWN;
+		default:			 return INVALID_KEY;
+	}
+}
+
 void GameController::keyboardEvent(unsigned char key, int /* x */, int /* y */)
 {
 	switch (key)
 	{
-		case 'a': case '4': m_lastKeyHit = KEY_PRESS_LEFT;	break;
-		case 'd': case '6': m_lastKeyHit = KEY_PRESS_RIGHT; break;
-		case 'w': case '8': m_lastKeyHit = KEY_PRESS_UP;	break;
-		case 's': case '2': m_lastKeyHit = KEY_PRESS_DOWN;	break;
-		case 't':			m_lastKeyHit = KEY_PRESS_TAB;	break;
 		case 'f':			m_singleStep = true;			break;
 		case 'r':			m_singleStep = false;			break;
-		case 'q': case 'Q': setGameState(quit);				break;
-		default:			m_lastKeyHit = key;				break;
+		case 'q': case 'Q': m_quitRequested = true;			break;
+		default:			queueKey(gameKey(key), true);	break;
 	}
 }
 
+void GameController::keyboardUpEvent(unsigned char key, int /* x */, int /* y */)
+{
+	queueKey(gameKey(key), false);
+}
+
 void GameController::specialKeyboardEvent(int key, int /* x */, int /* y */)
 {
-	switch (key)
+	queueKey(gameSpecialKey(key), true);
+}
+
+void GameController::specialKeyboardUpEvent(int key, int /* x */, int /* y */)
+{
+	queueKey(gameSpecialKey(key), false);
+}
+
+void GameController::queueKey(int key, bool pressed)
+{
+	if (key == INVALID_KEY)
+		return;
+	InputEvent e = { key, pressed, chrono::steady_clock::now() };
+	m_inputQueue.push(e);  // if the game is 256 keys behind, drop it
+}
+
+  // The key pressed longest ago that the game hasn't seen yet
+
+bool GameController::getLastKey(int& value)
+{
+	InputEvent e;
+	while (m_inputQueue.pop(e))
+	{
+		if (e.pressed)
+		{
+			m_heldKeys |= heldKeyBit(e.key);
+			value = e.key;
+			return true;
+		}
+		m_heldKeys &= ~heldKeyBit(e.key);
+	}
+	return false;
+}
+
+void GameController::takeTickInput(TickInput& input)
+{
+	input.clear();
+	InputEvent e;
+	while (m_inputQueue.pop(e))
 	{
-		case GLUT_KEY_LEFT:	 m_lastKeyHit = KEY_PRESS_LEFT;	 break;
-		case GLUT_KEY_RIGHT: m_lastKeyHit = KEY_PRESS_RIGHT; break;
-		case GLUT_KEY_UP:	 m_lastKeyHit = KEY_PRESS_UP;	 break;
-		case GLUT_KEY_DOWN:	 m_lastKeyHit = KEY_PRESS_DOWN;	 break;
-		default:			 m_lastKeyHit = INVALID_KEY;	 break;
+		unsigned int bit = heldKeyBit(e.key);
+		if (e.pressed)
+		{
+			m_heldKeys |= bit;
+			input.heldKeys |= bit;
+			input.addPress(e);
+			if (m_oldestUnshownInput == chrono::steady_clock::time_point())
+				m_oldestUnshownInput = e.time;
+		}
+		else
+			m_heldKeys &= ~bit;
 	}
+	input.heldKeys |= m_heldKeys;
 }
 
 void GameController::playSound(int soundID)
 {
-	if (soundID == SOUND_NONE)
-    {
-        SoundFX().abortClip();
-		return;
-    }
+	m_mixer->playSound(soundID);
+}
+
+void GameController::playSounds(const SoundBatch& batch)
+{
+	m_mixer->playSounds(batch);
+}
 
+void GameController::clipStarted(int soundID)
+{
 	SoundMapType::const_iterator p = m_soundMap.find(soundID);
 	if (p != m_soundMap.end())
-	{
-		string path = m_gw->assetDirectory();
-		if (!path.empty())
-			path += '/';
-		SoundFX().playClip(path + p->second);
-	}
+		m_soundFX.playClip(p->second);
+}
+
+void GameController::allClipsStopped()
+{
+	m_soundFX.abortClip();
 }
 
 void GameController::setGameState(GameControllerState s)
@@ -213,6 +406,7 @@ void GameController::setGameStateAfterPrompting(GameControllerState s,
 	m_secondMessage = secondMessage;
 	m_nextStateAfterPrompt = s;
 	setGameState(prompt);
+	publishPrompt();
 }
 
 void GameController::quitGame()
@@ -220,21 +414,57 @@ void GameController::quitGame()
 	setGameState(quit);
 }
 
+void GameController::runSimulation()
+{
+	chrono::steady_clock::time_point nextTick = chrono::steady_clock::now();
+	while (m_gameState != quit)
+	{
+		if (m_quitRequested)
+			setGameState(quit);
+		else
+			advanceOneTick();
+
+		nextTick += chrono::milliseconds(m_msPerTick);
+		chrono::steady_clock::time_point now = chrono::steady_clock::now();
+		if (now - nextTick > chrono::milliseconds(MAX_MS_BEHIND))
+			nextTick = now;  // e.g., stopped in a debugger; don't race to catch up
+		this_thread::sleep_until(nextTick);
+	}
+	m_mixer->stopAll();
+	m_simulationDone = true;
+}
+
+  // Run the state machine until the game has moved or is waiting for a key
+
+void GameController::advanceOneTick()
+{
+	for (;;)
+	{
+		GameControllerState s = m_gameState;
+		doSomething();
+		if (s == makemove  ||  s == singlestep  ||  s == prompt  ||  m_gameState == quit  ||
+			(s == startlevel  &&  m_gameState == startlevel))  // still getting ready
+			return;
+	}
+}
+
 void GameController::doSomething()
 {
 	switch (m_gameState)
 	{
-		case not_applicable:
-			break;
 		case welcome:
 			playSound(SOUND_THEME);
-			setGameStateAfterPrompting(init, "Welcome to NachenBlaster!",
+			prepareLevel(false);
+			setGameStateAfterPrompting(startlevel, "Welcome to NachenBlaster!",
 											"Press Enter to begin play...");
 			break;
-		case init:
+		case startlevel:
 			{
-				int status = m_gw->init();
-				SoundFX().abortClip();
+				  // Normally all this was done while the prompt was up
+				if (!m_levelPrepared  ||  !m_spritesUploaded)
+					break;
+				int status = m_preparedStatus;
+				m_mixer->stopAll();
 				if (status == GWSTATUS_PLAYER_WON)
 				{
 					m_playerWon = true;
@@ -249,50 +479,39 @@ void GameController::doSomething()
 			}
 			break;
 		case makemove:
-			m_curIntraFrameTick = ANIMATION_POSITIONS_PER_TICK;
-			m_nextStateAfterAnimate = not_applicable;
 			{
-				int status = m_gw->move();
+				int status = m_gw->tick();
+				publishGamePlay();
+				  // The prompts that follow a death or a finished level come
+				  // a tick later, so the player sees what happened.
 				if (status == GWSTATUS_PLAYER_DIED)
-				{
-					  // animate one last frame so the player can see what happened
-					m_nextStateAfterAnimate = (m_gw->isGameOver() ? gameover : contgame);
-				}
+					setGameState(m_gw->isGameOver() ? gameover : contgame);
 				else if (status == GWSTATUS_FINISHED_LEVEL)
 				{
 					m_gw->advanceToNextLevel();
-					  // animate one last frame so the player can see what happened
-					m_nextStateAfterAnimate = finishedlevel;
+					setGameState(finishedlevel);
 				}
+				else if (m_singleStep)
+					setGameState(singlestep);
 			}
-			setGameState(animate);
 			break;
-		case animate:
-			displayGamePlay();
-			if (m_curIntraFrameTick-- <= 0)
+		case singlestep:
 			{
-				if (m_nextStateAfterAnimate != not_applicable)
-					setGameState(m_nextStateAfterAnimate);
-				else
-				{
-					int key;
-					if (!m_singleStep  ||  getLastKey(key))
-						setGameState(makemove);
-				}
+				int key;
+				if (!m_singleStep  ||  getLastKey(key))
+					setGameState(makemove);
 			}
 			break;
 		case contgame:
-			setGameStateAfterPrompting(cleanup, "You lost a life!",
+			prepareLevel(true);
+			setGameStateAfterPrompting(startlevel, "You lost a life!",
 										"Press Enter to continue playing...");
 			break;
 		case finishedlevel:
-			setGameStateAfterPrompting(cleanup, "Woot! You finished the level!",
+			prepareLevel(true);
+			setGameStateAfterPrompting(startlevel, "Woot! You finished the level!",
 										"Press Enter to continue playing...");
 			break;
-		case cleanup:
-			m_gw->cleanUp();
-			setGameState(init);
-			break;
 		case gameover:
 			{
 				ostringstream oss;
@@ -303,7 +522,6 @@ void GameController::doSomething()
 			}
 			break;
 		case prompt:
-			drawPrompt(m_mainMessage, m_secondMessage);
 			{
 				int key;
 				if (getLastKey(key) && key == '\r')
@@ -311,13 +529,120 @@ void GameController::doSomething()
 			}
 			break;
 		case quit:
-            SoundFX().abortClip();
-			glutLeaveMainLoop();
 			break;
 	}
 }
 
-void GameController::displayGamePlay()
+void GameController::publishGamePlay()
+{
+	RenderSnapshot& snapshot = m_snapshots.back();
+	snapshot.showPrompt = false;
+	snapshot.sprites.clear();
+	GraphObject::drawAllObjectsInMotion(m_gw->graphObjects(),
+		[&snapshot](int imageID, int animationNumber, double prevX, double prevY, int prevAngle,
+					double x, double y, int angle, double size, int depth)
+		{
+			RenderSnapshot::Sprite sprite = {
+				imageID, animationNumber, prevX, prevY, prevAngle, x, y, angle, size, depth
+			};
+			snapshot.sprites.push_back(sprite);
+		});
+	snapshot.statText = m_gameStatText;
+	snapshot.publishedAt = chrono::steady_clock::now();
+	snapshot.inputTime = m_oldestUnshownInput;
+	m_oldestUnshownInput = chrono::steady_clock::time_point();
+	m_snapshots.publish();
+}
+
+void GameController::publishPrompt()
+{
+	RenderSnapshot& snapshot = m_snapshots.back();
+	snapshot.showPrompt = true;
+	snapshot.sprites.clear();
+	snapshot.statText.clear();
+	snapshot.mainMessage = m_mainMessage;
+	snapshot.secondMessage = m_secondMessage;
+	snapshot.publishedAt = chrono::steady_clock::now();
+	snapshot.inputTime = chrono::steady_clock::time_point();
+	m_snapshots.publish();
+}
+
+void GameController::refresh()
+{
+	if (m_simulationDone)
+	{
+		glutLeaveMainLoop();
+		return;
+	}
+	if (m_spritesLoaded  &&  !m_spritesUploaded  &&  !m_quitRequested)
+		uploadSprites();
+	bool fresh = m_snapshots.acquireLatest();
+	const RenderSnapshot& snapshot = m_snapshots.front();
+	if (fresh  ||  !snapshot.showPrompt)  // the game moves between ticks; a prompt doesn't
+	{
+		display();
+
+		  // Drawing runs a tick behind, so a tick's keys have had their whole
+		  // effect on screen only once a frame is blended all the way to that
+		  // tick: a tick's time after it was published, or the first frame
+		  // of the tick after it, whichever comes first.  (That doesn't count
+		  // the wait for the display to actually show the swapped buffer.)
+		chrono::steady_clock::time_point now = chrono::steady_clock::now();
+		if (fresh)
+		{
+			if (!snapshot.showPrompt)
+				takeLatencySample(now);
+			m_inputBeingShown = (snapshot.showPrompt ? chrono::steady_clock::time_point() : snapshot.inputTime);
+		}
+		if (now - snapshot.publishedAt >= chrono::milliseconds(m_msPerTick))
+			takeLatencySample(now);
+	}
+}
+
+void GameController::takeLatencySample(chrono::steady_clock::time_point now)
+{
+	if (m_inputBeingShown == chrono::steady_clock::time_point())
+		return;
+	chrono::duration<double, milli> latency = now - m_inputBeingShown;
+	m_keyToScreen.add(latency.count());
+	m_inputBeingShown = chrono::steady_clock::time_point();
+}
+
+void GameController::display()
+{
+	const RenderSnapshot& snapshot = m_snapshots.front();
+	if (snapshot.showPrompt)
+	{
+		m_mainMessageLine.setText(m_font, snapshot.mainMessage);
+		m_secondMessageLine.setText(m_font, snapshot.secondMessage);
+		drawPrompt(m_mainMessageLine, m_secondMessageLine);
+	}
+	else
+	{
+		  // Drawing runs a tick behind: as the next tick's time passes, the
+		  // sprites go from where the latest snapshot says they were to
+		  // where it says they are.
+		chrono::duration<double, milli> elapsed = chrono::steady_clock::now() - snapshot.publishedAt;
+		double fraction = elapsed.count() / m_msPerTick;
+		displayGamePlay(snapshot, min(max(fraction, 0.0), 1.0));
+	}
+}
+
+static double blend(double from, double to, double fraction)
+{
+	return from + (to - from) * fraction;
+}
+
+  // Turn the shorter way around
+static int blendDirection(int from, int to, double fraction)
+{
+	int turn = normalizeDegrees(to - from);
+	if (turn > 180)
+		turn -= 360;
+	return from + static_cast<int>(turn * fraction + (turn < 0 ? -.5 : .5));
+}
+
+void GameController::displayGamePlay(const RenderSnapshot& snapshot, double fraction)
 {
 	glEnable(GL_DEPTH_TEST); // must be done each time before displaying graphics or gets disabled for some reason
 	glLoadIdentity();
@@ -331,15 +656,19 @@ void GameController::displayGamePlay()
 #pragma GCC diagnostic pop
 #endif
 
-    GraphObject::drawAllObjects(
-        [=](int imageID, int animationNumber, double x, double y, int angle, double size)
-        {
-            int frame = animationNumber % m_spriteManager.getNumFrames(imageID);
-            m_spriteManager.plotSprite(imageID, frame, x, y, angle, size);
-            
-        });
+    m_spriteManager.beginBatch();
+    for (const RenderSnapshot::Sprite& s : snapshot.sprites)
+    {
+        int frame = s.animationNumber % m_spriteManager.getNumFrames(s.imageID);
+        m_spriteManager.queueSprite(s.imageID, frame, blend(s.prevX, s.x, fraction),
+                                    blend(s.prevY, s.y, fraction),
+                                    blendDirection(s.prevDirection, s.direction, fraction),
+                                    s.size, s.depth);
+    }
+    m_spriteManager.endBatch();
 
-	drawScoreAndLives(m_gameStatText);
+	m_statLine.setText(m_font, snapshot.statText);
+	drawScoreAndLives(m_statLine, m_flicker, m_statTextColor);
 
 	glutSwapBuffers();
 }
@@ -360,53 +689,35 @@ void GameController::reshape (int w, int h)
 	glMatrixMode (GL_MODELVIEW);
 }
 
-static void doOutputStroke(double x, double y, double z, double size, const char* str, bool centered)
+static void outputStrokeCentered(double y, double z, const StrokeText& text)
 {
-	if (centered)
-	{
-		double len = glutStrokeLength(GLUT_STROKE_ROMAN, reinterpret_cast<const unsigned char*>(str)) / FONT_SCALEDOWN;
-		x = -len / 2;
-		size = 1;
-	}
-	GLfloat scaledSize = static_cast<GLfloat>(size / FONT_SCALEDOWN);
+	double x = -text.length() / FONT_SCALEDOWN / 2;
+	GLfloat scaledSize = static_cast<GLfloat>(1 / FONT_SCALEDOWN);
 	glPushMatrix();
 	glLineWidth(1);
 	glLoadIdentity();
 	glTranslatef(static_cast<GLfloat>(x), static_cast<GLfloat>(y), static_cast<GLfloat>(z));
 	glScalef(scaledSize, scaledSize, scaledSize);
-	for ( ; *str != '\0'; str++)
-		glutStrokeCharacter(GLUT_STROKE_ROMAN, *str);
+	text.draw();
 	glPopMatrix();
 }
 
-//static void outputStroke(double x, double y, double z, double size, const char* str)
-//{
-//	doOutputStroke(x, y, z, size, str, false);
-//}
-
-static void outputStrokeCentered(double y, double z, const char* str)
-{
-	doOutputStroke(0, y, z, 1, str, true);
-}
-
-static void drawPrompt(string mainMessage, string secondMessage)
+static void drawPrompt(const StrokeText& mainMessage, const StrokeText& secondMessage)
 {
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 	glColor3f (1.0, 1.0, 1.0);
 	glLoadIdentity ();
-	outputStrokeCentered(1, -5, mainMessage.c_str());
-	outputStrokeCentered(-1, -5, secondMessage.c_str());
+	outputStrokeCentered(1, -5, mainMessage);
+	outputStrokeCentered(-1, -5, secondMessage);
 	glutSwapBuffers();
 }
 
-static void drawScoreAndLives(string gameStatText)
+static void drawScoreAndLives(const StrokeText& gameStatText, RandomGenerator& flicker, float rgb[3])
 {
-	static int RATE = 1;
-	static GLfloat rgb[3] =
-		{ static_cast<GLfloat>(.6), static_cast<GLfloat>(.6), static_cast<GLfloat>(.6) };
+	const int RATE = 1;
 	for (int k = 0; k < 3; k++)
 	{
-		double strength = rgb[k] + randInt(-RATE, RATE) / 100.0;
+		double strength = rgb[k] + flicker.randInt(-RATE, RATE) / 100.0;
 		if (strength < .6)
 			strength = .6;
 		else if (strength > 1.0)
@@ -414,5 +725,5 @@ static void drawScoreAndLives(string gameStatText)
 		rgb[k] = static_cast<GLfloat>(strength);
 	}
 	glColor3f(rgb[0], rgb[1], rgb[2]);
-	outputStrokeCentered(SCORE_Y, SCORE_Z, gameStatText.c_str());
+	outputStrokeCentered(SCORE_Y, SCORE_Z, gameStatText);
 }
@@ -1,9 +1,24 @@
 #ifndef GAMECONTROLLER_H_
 #define GAMECONTROLLER_H_
 
+#include "GameHost.h"
 #include "SpriteManager.h"
+#include "SoundFX.h"
+#include "AudioMixer.h"
+#include "AssetLoader.h"
+#include "TaskPool.h"
+#include "StrokeFont.h"
+#include "RandomGenerator.h"
+#include "TripleBuffer.h"
+#include "InputEvent.h"
+#include "SpscQueue.h"
+#include "LatencyHistogram.h"
 #include <string>
+#include <vector>
 #include <map>
+#include <atomic>
+#include <chrono>
+#include <memory>
 #include <iostream>
 #include <sstream>
 
@@ -12,74 +27,180 @@ const int INVALID_KEY = 0;
 class GraphObject;
 class GameWorld;
 
-class GameController
+  // Everything the window shows at the end of one tick, captured by the
+  // simulation thread so that the drawing thread never touches the
+  // GameWorld.  Each sprite carries where it was at the end of the previous
+  // tick too, so the drawing thread can move it smoothly in between.
+
+struct RenderSnapshot
+{
+	struct Sprite
+	{
+		int	   imageID;
+		int	   animationNumber;
+		double prevX;
+		double prevY;
+		int	   prevDirection;
+		double x;
+		double y;
+		int	   direction;
+		double size;
+		int	   depth;
+	};
+
+	bool				showPrompt;		// if so, draw the messages instead of the game
+	std::vector<Sprite> sprites;		// in drawing order, deepest first
+	std::string			statText;
+	std::string			mainMessage;
+	std::string			secondMessage;
+	std::chrono::steady_clock::time_point publishedAt;
+	std::chrono::steady_clock::time_point inputTime;	// of the oldest key press this
+														// tick acted on, if any
+
+	RenderSnapshot()
+	 : showPrompt(false)
+	{
+	}
+};
+
+  // Runs a GameWorld in a GLUT window.  GLUT only supports one window's
+  // worth of callbacks per process, so only one GameController can be
+  // running at a time, but nothing about it is global: it is an ordinary
+  // object the program creates and owns.
+  //
+  // The game runs on a thread of its own at a fixed number of ticks per
+  // second, publishing a RenderSnapshot after each one.  The GLUT thread
+  // just draws the latest snapshot and turns keystrokes into keys for the
+  // game to pick up, so a slow frame never slows the game down and a slow
+  // tick never stalls the window.  Keys go down and come up on the GLUT
+  // thread and reach the game through a lock-free queue, so none are lost
+  // between ticks.  How long each key press takes to reach the screen is
+  // measured, and a summary printed when the game ends.  The window is
+  // redrawn far more often than the game ticks, each time placing the
+  // sprites the fraction of the way through the latest tick that has gone
+  // by on the clock.  Sounds are mixed on a third thread, so asking for one
+  // costs the game almost nothing.
+  //
+  // Whatever can be done while a prompt is up is done then, on a
+  // background thread: the sprites are decoded and mipmapped while the
+  // welcome prompt waits for Enter, and the next level is cleaned up after
+  // and initialized while that prompt or a between-levels one does, so
+  // Enter starts play straight away.
+
+class GameController : public GameHost, private AudioMixerListener
 {
   public:
-	void run(int argc, char* argv[], GameWorld* gw, std::string windowTitle);
+	GameController();
 
-	bool getLastKey(int& value)
+	  // The game is tuned for a tick every 15 ms.  Running it slower saves
+	  // CPU time, with motion still smooth but the game itself slower.
+	void setMsPerTick(int ms)
 	{
-		if (m_lastKeyHit != INVALID_KEY)
-		{
-			value = m_lastKeyHit;
-			m_lastKeyHit = INVALID_KEY;
-			return true;
-		}
-		return false;
+		m_msPerTick = (ms < 1 ? 1 : ms);
 	}
 
-	void playSound(int soundID);
-
-	void setGameStatText(std::string text)
+	  // Write all the sound the game makes to a WAV file instead of playing
+	  // it (or throwing it away, where there's no way to play it).
+	void setAudioOutputFile(std::string path)
 	{
-		m_gameStatText = text;
+		m_audioOutputPath = path;
 	}
 
-	void doSomething();
+	void run(int argc, char* argv[], GameWorld* gw, std::string windowTitle);
 
-	void reshape(int w, int h);
-	void keyboardEvent(unsigned char key, int x, int y);
-	void specialKeyboardEvent(int key, int x, int y);
+	virtual bool getLastKey(int& value);
+	virtual void takeTickInput(TickInput& input);
 
-	void quitGame();
+	virtual void playSound(int soundID);
+	virtual void playSounds(const SoundBatch& batch);
 
-	  // Meyers singleton pattern
-	static GameController& getInstance()
+	virtual void setGameStatText(const char* text)
 	{
-		static GameController instance;
-		return instance;
+		m_gameStatText = text;  // reuses the string's buffer
 	}
 
+	  // Called on the GLUT thread
+	void refresh();
+	void display();
+	void reshape(int w, int h);
+	void keyboardEvent(unsigned char key, int x, int y);
+	void keyboardUpEvent(unsigned char key, int x, int y);
+	void specialKeyboardEvent(int key, int x, int y);
+	void specialKeyboardUpEvent(int key, int x, int y);
+
+	virtual void quitGame();
+
 private:
 	enum GameControllerState : int;
 
 	GameWorld*	m_gw;
 	GameControllerState	m_gameState;
 	GameControllerState	m_nextStateAfterPrompt;
-	GameControllerState	m_nextStateAfterAnimate;
-	int			m_lastKeyHit;
-	bool		m_singleStep;
+	SpscQueue<InputEvent, 256> m_inputQueue;	// GLUT thread to simulation thread
+	unsigned int		m_heldKeys;		// HELD_* bits; simulation thread only
+	std::chrono::steady_clock::time_point m_oldestUnshownInput;	// simulation thread only
+	LatencyHistogram	m_keyToScreen;	// GLUT thread only
+	std::chrono::steady_clock::time_point m_inputBeingShown;	// GLUT thread only
+	std::atomic<bool>	m_singleStep;
+	std::atomic<bool>	m_quitRequested;	// by the user, from the GLUT thread
+	std::atomic<bool>	m_simulationDone;
+	int			m_msPerTick;
 	std::string m_gameStatText;
 	std::string m_mainMessage;
 	std::string m_secondMessage;
-	int			m_curIntraFrameTick;
 	using SoundMapType = std::map<int, std::string>;
 	using DrawMapType =  std::map<int, std::string>;
-	SoundMapType  m_soundMap;
+	SoundMapType  m_soundMap;		// full paths of the WAV files
 	bool		  m_playerWon;
 	SpriteManager m_spriteManager;
+	SoundFXController m_soundFX;	// used only on the mixing thread
+	std::string	  m_audioOutputPath;
+	AssetPack	  m_assetPack;		// the mixer may play straight from it
+	std::unique_ptr<AudioSink>  m_audioSink;
+	std::unique_ptr<AudioMixer> m_mixer;
+	float		  m_statTextColor[3];	// flickers from frame to frame
+	RandomGenerator m_flicker;
+	StrokeFont	  m_font;
+	StrokeText	  m_statLine;
+	StrokeText	  m_mainMessageLine;
+	StrokeText	  m_secondMessageLine;
+	TripleBuffer<RenderSnapshot> m_snapshots;
+	TaskPool	  m_loaderPool;		// decodes assets for m_background's tasks
+	LoadedAssets  m_loadedSprites;	// from m_background to the GLUT thread
+	std::string	  m_spriteLoadError;
+	std::string	  m_spriteSource;
+	double		  m_spriteLoadMs;
+	std::atomic<bool> m_spritesLoaded;		// m_loadedSprites is ready to upload
+	std::atomic<bool> m_spritesUploaded;
+	int			  m_preparedStatus;		// what init said about the prepared level
+	std::atomic<bool> m_levelPrepared;
+	TaskPool	  m_background;		// last, so it's finished with the rest first
 
 	void setGameState(GameControllerState s);
 	void setGameStateAfterPrompting(GameControllerState s,
 							std::string mainMessage, std::string secondMessage);
 
 	void initDrawersAndSounds();
-	void displayGamePlay();
-};
+	void createMixer();
+	void loadSprites(int atlasSize, bool mipmapped);
+	void uploadSprites();	// on the GLUT thread
+	void prepareLevel(bool cleanUpFirst);
+
+	  // Called on the mixing thread
+	virtual void clipStarted(int soundID);
+	virtual void allClipsStopped();
+
+	  // Called on the simulation thread
+	void runSimulation();
+	void advanceOneTick();
+	void doSomething();
+	void publishGamePlay();
+	void publishPrompt();
 
-inline GameController& Game()
-{
-	return GameController::getInstance();
-}
+	  // Called on the GLUT thread
+	void queueKey(int key, bool pressed);
+	void displayGamePlay(const RenderSnapshot& snapshot, double fraction);
+	void takeLatencySample(std::chrono::steady_clock::time_point now);
+};
 
 #endif // GAMECONTROLLER_H_
@@ -0,0 +1,117 @@
+#ifndef GAMEHOST_H_
+#define GAMEHOST_H_
+
+#include "GameConstants.h"
+#include "InputEvent.h"
+#include "SoundBatch.h"
+#include <string>
+
+  // Bits for the keys whose being held down matters to the game
+const unsigned int HELD_LEFT	= 1 << 0;
+const unsigned int HELD_RIGHT	= 1 << 1;
+const unsigned int HELD_UP		= 1 << 2;
+const unsigned int HELD_DOWN	= 1 << 3;
+const unsigned int HELD_SPACE	= 1 << 4;
+const unsigned int HELD_TAB		= 1 << 5;
+
+  // Return the HELD_* bit for key, or 0 if it has none
+inline unsigned int heldKeyBit(int key)
+{
+	switch (key)
+	{
+		case KEY_PRESS_LEFT:  return HELD_LEFT;
+		case KEY_PRESS_RIGHT: return HELD_RIGHT;
+		case KEY_PRESS_UP:	  return HELD_UP;
+		case KEY_PRESS_DOWN:  return HELD_DOWN;
+		case KEY_PRESS_SPACE: return HELD_SPACE;
+		case KEY_PRESS_TAB:	  return HELD_TAB;
+		default:			  return 0;
+	}
+}
+
+  // The input for one tick: every key pressed since the last tick, oldest
+  // first, and the HELD_* bits of the keys that were down at any time in
+  // between (so a key tapped and released between two ticks still counts).
+  // Keys pressed beyond MAX_EVENTS in one tick are dropped.
+
+struct TickInput
+{
+	static const int MAX_EVENTS = 32;
+
+	InputEvent	 events[MAX_EVENTS];
+	int			 numEvents;
+	unsigned int heldKeys;
+
+	void clear()
+	{
+		numEvents = 0;
+		heldKeys = 0;
+	}
+
+	void addPress(const InputEvent& e)
+	{
+		if (numEvents < MAX_EVENTS)
+			events[numEvents++] = e;
+	}
+};
+
+  // Where a GameWorld gets the keys the user hit.
+
+class InputSource
+{
+  public:
+	virtual ~InputSource()
+	{
+	}
+
+	virtual bool getLastKey(int& value) = 0;
+
+	  // Fill in the input for the next tick.  Sources that only know about
+	  // one key at a time needn't override this: the tick gets the key
+	  // getLastKey returns, if any, with nothing held.
+	virtual void takeTickInput(TickInput& input)
+	{
+		input.clear();
+		int key;
+		if (getLastKey(key))
+		{
+			InputEvent e = { key, true, std::chrono::steady_clock::time_point() };
+			input.addPress(e);
+		}
+	}
+};
+
+  // Where a GameWorld sends the sound effects it wants played.
+
+class SoundSink
+{
+  public:
+	virtual ~SoundSink()
+	{
+	}
+
+	virtual void playSound(int soundID) = 0;
+
+	  // Play everything a tick asked for at once.  Sinks that can't do
+	  // better get each distinct sound once, highest priority first.
+	virtual void playSounds(const SoundBatch& batch)
+	{
+		if (batch.stopsFirst())
+			playSound(SOUND_NONE);
+		for (int k = 0; k < batch.size(); k++)
+			playSound(batch.soundID(k));
+	}
+};
+
+  // Everything a GameWorld needs from whatever is driving it.  GameController
+  // is the windowed implementation; HeadlessController runs with no window,
+  // no OpenGL and no sound device.
+
+class GameHost : public InputSource, public SoundSink
+{
+  public:
+	virtual void setGameStatText(const char* text) = 0;
+	virtual void quitGame() = 0;
+};
+
+#endif // GAMEHOST_H_
@@ -1,27 +1,96 @@
 #include "GameWorld.h"
-#include "GameController.h"
+#include "GameHost.h"
+#include "Replay.h"
 #include <string>
 #include <cstdlib>
+#include <random>
 using namespace std;
 
+uint64_t GameWorld::nondeterministicSeed()
+{
+	random_device rd;
+	return (static_cast<uint64_t>(rd()) << 32) | rd();
+}
+
 bool GameWorld::getKey(int& value)
 {
-	bool gotKey = m_controller->getLastKey(value);
+	GameHost* host = m_context.host();
+	bool gotKey = host->getLastKey(value);
 
 	if (gotKey)
 	{
+		if (m_context.recorder() != nullptr)
+			m_context.recorder()->recordKey(value);
 		if (value == 'q'  ||  value == '\x03')  // CTRL-C
-			m_controller->quitGame();
+			host->quitGame();
 	}
 	return gotKey;
 }
 
+const TickInput& GameWorld::drainInput()
+{
+	GameHost* host = m_context.host();
+	host->takeTickInput(m_tickInput);
+
+	ReplayRecorder* recorder = m_context.recorder();
+	for (int k = 0; k < m_tickInput.numEvents; k++)
+	{
+		int key = m_tickInput.events[k].key;
+		if (recorder != nullptr)
+			recorder->recordKey(key);
+		if (key == 'q'  ||  key == '\x03')  // CTRL-C
+			host->quitGame();
+	}
+	if (recorder != nullptr  &&  m_tickInput.heldKeys != 0)
+		recorder->recordKey(REPLAY_HELD_KEYS | m_tickInput.heldKeys);
+	return m_tickInput;
+}
+
 void GameWorld::playSound(int soundID)
 {
-	m_controller->playSound(soundID);
+	m_sounds.add(soundID);
+}
+
+void GameWorld::flushSounds()
+{
+	if (m_sounds.empty())
+		return;
+	m_sounds.finish();
+	m_context.host()->playSounds(m_sounds);
+	m_sounds.clear();
 }
 
-void GameWorld::setGameStatText(string text)
+void GameWorld::setGameStatText(const string& text)
 {
-	m_controller->setGameStatText(text);
+	m_context.host()->setGameStatText(text.c_str());
+}
+
+void GameWorld::setGameStatText(const char* text)
+{
+	m_context.host()->setGameStatText(text);
+}
+
+int GameWorld::tick()
+{
+	int status = move();
+	flushSounds();
+	if (m_context.recorder() != nullptr)
+		m_context.recorder()->endTick(stateHash());
+	return status;
+}
+
+uint64_t GameWorld::stateHash() const
+{
+	StateHasher h;
+	h.addInt(m_lives);
+	h.addInt(m_score);
+	h.addInt(m_level);
+	for (int k = 0; k < NUM_RNG_STREAMS; k++)
+	{
+		uint64_t state, inc;
+		m_context.random(k).getState(state, inc);
+		h.addInt(state);
+		h.addInt(inc);
+	}
+	return h.value();
 }
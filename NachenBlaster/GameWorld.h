@@ -2,11 +2,62 @@
 #define GAMEWORLD_H_
 
 #include "GameConstants.h"
+#include "RandomGenerator.h"
+#include "WorldContext.h"
+#include "GameHost.h"
 #include <string>
+#include <cstdint>
+#include <cstring>
 
 const int START_PLAYER_LIVES = 3;
 
-class GameController;
+  // Accumulates a 64-bit FNV-1a hash of a sequence of numbers.
+
+class StateHasher
+{
+  public:
+	StateHasher()
+	 : m_hash(14695981039346656037ULL)
+	{
+	}
+
+	void addInt(std::uint64_t v)
+	{
+		for (int k = 0; k < 8; k++)
+		{
+			m_hash ^= (v >> (8 * k)) & 0xff;
+			m_hash *= 1099511628211ULL;
+		}
+	}
+
+	void addDouble(double d)
+	{
+		std::uint64_t bits;
+		std::memcpy(&bits, &d, sizeof(bits));
+		addInt(bits);
+	}
+
+	std::uint64_t value() const
+	{
+		return m_hash;
+	}
+
+  private:
+	std::uint64_t m_hash;
+};
+
+  // Everything a GameWorld itself knows about a game in progress, with no
+  // pointers, so it can be copied around with memcpy.
+
+struct GameWorldState
+{
+	unsigned int	lives;
+	unsigned int	score;
+	unsigned int	level;
+	std::uint64_t	seed;
+	std::uint64_t	rngState[NUM_RNG_STREAMS];
+	std::uint64_t	rngInc[NUM_RNG_STREAMS];
+};
 
 class GameWorld
 {
@@ -14,8 +65,9 @@ public:
 
 	GameWorld(std::string assetDir)
 	 : m_lives(START_PLAYER_LIVES), m_score(0), m_level(1),
-	   m_controller(nullptr), m_assetDir(assetDir)
+	   m_assetDir(assetDir)
 	{
+		seedRandom(nondeterministicSeed());
 	}
 
 	virtual ~GameWorld()
@@ -27,11 +79,27 @@ public:
 	virtual int move() = 0;
 	virtual void cleanUp() = 0;
 
-	void setGameStatText(std::string text);
+	  // A hash of everything that determines how the game will go on from
+	  // here, for checking that a replay hasn't diverged.
+	virtual std::uint64_t stateHash() const;
+
+	void setGameStatText(const std::string& text);
+	void setGameStatText(const char* text);
 
 	bool getKey(int& value);
+
+	  // Take everything the user did since the last tick: the keys pressed,
+	  // oldest first, and which keys are being held down.  Call this at most
+	  // once per tick, instead of getKey.
+	const TickInput& drainInput();
+
+	  // Sounds are collected and played together when the tick is over
 	void playSound(int soundID);
 
+	  // Hand the sounds asked for so far to the host as one batch.  tick()
+	  // does this; call it after playing sounds outside of a tick.
+	void flushSounds();
+
 	unsigned int getLevel() const
 	{
 		return m_level;
@@ -52,6 +120,44 @@ public:
 		m_lives++;
 	}
 
+	  // Restart every random number stream from seed.  The same seed and the
+	  // same keys always play out the same game.
+	void seedRandom(std::uint64_t seed)
+	{
+		m_context.seedRandom(seed);
+	}
+
+	std::uint64_t randomSeed() const
+	{
+		return m_context.randomSeed();
+	}
+
+	void saveState(GameWorldState& state) const
+	{
+		state.lives = m_lives;
+		state.score = m_score;
+		state.level = m_level;
+		state.seed = m_context.randomSeed();
+		for (int k = 0; k < NUM_RNG_STREAMS; k++)
+			m_context.random(k).getState(state.rngState[k], state.rngInc[k]);
+	}
+
+	void restoreState(const GameWorldState& state)
+	{
+		m_lives = state.lives;
+		m_score = state.score;
+		m_level = state.level;
+		m_context.seedRandom(state.seed);
+		for (int k = 0; k < NUM_RNG_STREAMS; k++)
+			m_context.random(k).setState(state.rngState[k], state.rngInc[k]);
+	}
+
+	  // Return the generator for one of the RNG_* streams
+	RandomGenerator& random(int stream)
+	{
+		return m_context.random(stream);
+	}
+
 	unsigned int getScore() const
 	{
 		return m_score;
@@ -73,10 +179,40 @@ public:
 	{
 		++m_level;
 	}
+
+	  // Go back to the start of a game: full lives, no score, first level
+	void startNewGame()
+	{
+		m_lives = START_PLAYER_LIVES;
+		m_score = 0;
+		m_level = 1;
+	}
    
-	void setController(GameController* controller)
+	void setController(GameHost* controller)
 	{
-		m_controller = controller;
+		m_context.setHost(controller);
+	}
+
+	  // Record every key this world consumes, tick by tick, to recorder (or
+	  // stop recording if it's null).
+	void setRecorder(ReplayRecorder* recorder)
+	{
+		m_context.setRecorder(recorder);
+	}
+
+	  // Run one tick of the game: what the framework calls instead of move().
+	int tick();
+
+	  // Everything this world runs with besides the game itself
+	WorldContext& context()
+	{
+		return m_context;
+	}
+
+	  // The objects this world draws
+	GraphObjectRegistry& graphObjects()
+	{
+		return m_context.graphObjects();
 	}
 
 	std::string assetDirectory() const
@@ -88,8 +224,12 @@ private:
 	unsigned int	m_lives;
 	unsigned int	m_score;
 	unsigned int	m_level;
-	GameController* m_controller;
 	std::string		m_assetDir;
+	WorldContext	m_context;
+	TickInput		m_tickInput;
+	SoundBatch		m_sounds;
+
+	static std::uint64_t nondeterministicSeed();
 };
 
 #endif // GAMEWORLD_H_
@@ -2,26 +2,80 @@
 #define GRAPHOBJ_H_
 
 #include "GameConstants.h"
-#include <set>
+#include <vector>
+#include <cstddef>
 
-const int ANIMATION_POSITIONS_PER_TICK = 1;
+class GraphObject;
 
+  // The GraphObjects that make up one world's picture, by depth.  Every
+  // GameWorld has its own, so worlds running on different threads never
+  // touch each other's.
+  //
+  // Each depth is a flat list in the order the objects were created.  An
+  // object knows its own slot, so adding and removing one is O(1): removal
+  // just empties the slot, and the list is squeezed (keeping its order) once
+  // more than half of it is empty.
+
+class GraphObjectRegistry
+{
+  public:
+	static const int NUM_DEPTHS = 4;
+
+	void add(GraphObject* go);
+	void remove(GraphObject* go);
+
+	  // Call f on every object at depth, in the order they were created
+	template<typename Func>
+	void forEach(int depth, Func f) const
+	{
+		for (GraphObject* go : m_lists[depth].objects)
+		{
+			if (go != nullptr)
+				f(go);
+		}
+	}
+
+  private:
+	struct DepthList
+	{
+		std::vector<GraphObject*> objects;
+		std::size_t				  numEmpty;
+
+		DepthList()
+		 : numEmpty(0)
+		{
+		}
+	};
+
+	DepthList m_lists[NUM_DEPTHS];
+
+	static int listFor(int depth)
+	{
+		if (depth >= 0  &&  depth < NUM_DEPTHS)
+			return depth;
+		else
+			return 0;
+	}
+
+	void squeeze(DepthList& list);
+};
 
 class GraphObject
 {
 protected:
-	GraphObject(int imageID, double startX, double startY, int dir = 0, double size = 1.0, int depth = 0)
-	 : m_imageID(imageID), m_animationNumber(0), m_x(startX), m_y(startY),
-	   m_destX(startX), m_destY(startY), m_direction(dir),
-	   m_size(size <= 0 ? 1 : size), m_depth(depth)
+	GraphObject(GraphObjectRegistry& registry, int imageID, double startX, double startY, int dir = 0, double size = 1.0, int depth = 0)
+	 : m_registry(&registry), m_imageID(imageID), m_animationNumber(0),
+	   m_x(startX), m_y(startY), m_destX(startX), m_destY(startY),
+	   m_direction(dir), m_prevDirection(dir), m_size(size <= 0 ? 1 : size), m_depth(depth),
+	   m_registryIndex(0)
 	{
-		getGraphObjects(m_depth).insert(this);
+		m_registry->add(this);
 	}
 
 public:
 	virtual ~GraphObject()
 	{
-		getGraphObjects(m_depth).erase(this);
+		m_registry->remove(this);
 	}
 
     double getX() const
@@ -43,6 +97,11 @@ public:
         m_animationNumber++;
     }
 
+    int getImageID() const
+    {
+        return m_imageID;
+    }
+
     int getDirection() const
     {
         return m_direction;
@@ -72,21 +131,26 @@ public:
 		return RADIUS_PER_UNIT * m_size;
 	}
 
+      // Hand plotFunc every object, deepest first, with where it was and
+      // which way it faced the last time it was drawn as well as where it
+      // is now, so that a renderer can move it smoothly from one to the
+      // other.
     template<typename Func>
-    static void drawAllObjects(Func plotFunc)
+    static void drawAllObjectsInMotion(GraphObjectRegistry& registry, Func plotFunc)
     {
-        for (int depth = NUM_DEPTHS - 1; depth >= 0; depth--)
+        for (int depth = GraphObjectRegistry::NUM_DEPTHS - 1; depth >= 0; depth--)
         {
-            for (GraphObject* go : getGraphObjects(depth))
+            registry.forEach(depth, [&](GraphObject* go)
             {
+                plotFunc(go->m_imageID, go->m_animationNumber, go->m_x, go->m_y, go->m_prevDirection,
+                         go->m_destX, go->m_destY, go->m_direction, go->m_size, depth);
                 go->animate();
-                plotFunc(go->m_imageID, go->m_animationNumber, go->m_x, go->m_y, go->m_direction, go->m_size);
-            }
+            });
         }
     }
 
 private:
-    static const int NUM_DEPTHS = 4;
+    GraphObjectRegistry* m_registry;
     int             m_imageID;
     unsigned int    m_animationNumber;
     double          m_x;
@@ -94,40 +158,55 @@ private:
     double          m_destX;
     double          m_destY;
     int				m_direction;
+    int             m_prevDirection;    // as of the last animate()
     double          m_size;
     int             m_depth;
+    std::size_t     m_registryIndex;    // slot in m_registry's list for m_depth
 
+    friend class GraphObjectRegistry;
+
+      // Catch up the drawn position and direction with the real ones
     void animate()
     {
         m_x = m_destX;
         m_y = m_destY;
-        // moveALittle(m_x, m_destX);
-        // moveALittle(m_y, m_destY);
-    }
- 
-    void moveALittle(double& from, double& to)
-    {
-        static const double DISTANCE = 1.0/ANIMATION_POSITIONS_PER_TICK;
-        if (to - from >= DISTANCE)
-            from += DISTANCE;
-        else if (from - to >= DISTANCE)
-            from -= DISTANCE;
-        else
-            from = to;
+        m_prevDirection = m_direction;
     }
 
-    static std::set<GraphObject*>& getGraphObjects(int depth)
-    {
-        static std::set<GraphObject*> m_graphObjects[NUM_DEPTHS];
-        if (depth < NUM_DEPTHS)
-            return m_graphObjects[depth];
-        else
-            return m_graphObjects[0];         // empty;
-    }
-    
       // Prevent copying or assigning GraphObjects
     GraphObject(const GraphObject&) = delete;
     GraphObject& operator=(const GraphObject&) = delete;
 };
 
+inline void GraphObjectRegistry::add(GraphObject* go)
+{
+	DepthList& list = m_lists[listFor(go->m_depth)];
+	go->m_registryIndex = list.objects.size();
+	list.objects.push_back(go);
+}
+
+inline void GraphObjectRegistry::remove(GraphObject* go)
+{
+	DepthList& list = m_lists[listFor(go->m_depth)];
+	list.objects[go->m_registryIndex] = nullptr;
+	list.numEmpty++;
+	if (list.numEmpty * 2 > list.objects.size())
+		squeeze(list);
+}
+
+inline void GraphObjectRegistry::squeeze(DepthList& list)
+{
+	std::size_t kept = 0;
+	for (GraphObject* go : list.objects)
+	{
+		if (go != nullptr)
+		{
+			go->m_registryIndex = kept;
+			list.objects[kept++] = go;
+		}
+	}
+	list.objects.resize(kept);
+	list.numEmpty = 0;
+}
+
 #endif // GRAPHOBJ_H_
@@ -0,0 +1,53 @@
+#include "HeadlessController.h"
+#include "GameWorld.h"
+#include "GameConstants.h"
+using namespace std;
+
+HeadlessStats HeadlessController::run(GameWorld* gw, long long maxTicks)
+{
+	gw->setController(this);
+	m_quit = false;
+
+	HeadlessStats stats = { 0, 0, 0, false };
+
+	int status = gw->init();
+	while (status != GWSTATUS_PLAYER_WON  &&  status != GWSTATUS_LEVEL_ERROR  &&
+		   stats.ticks < maxTicks  &&  !m_quit)
+	{
+		if (!beforeTick(gw))
+			break;
+		status = gw->tick();
+		stats.ticks++;
+		afterTick(gw, status);
+		if (status == GWSTATUS_PLAYER_DIED)
+		{
+			stats.livesLost++;
+			if (gw->isGameOver())
+			{
+				stats.gameOver = true;
+				break;
+			}
+			gw->cleanUp();
+			status = gw->init();
+		}
+		else if (status == GWSTATUS_FINISHED_LEVEL)
+		{
+			stats.levelsFinished++;
+			gw->advanceToNextLevel();
+			gw->cleanUp();
+			status = gw->init();
+		}
+	}
+	gw->cleanUp();
+	return stats;
+}
+
+bool RandomInputSource::getLastKey(int& value)
+{
+	static const int choices[NUM_CHOICES] = {
+		KEY_PRESS_LEFT, KEY_PRESS_RIGHT, KEY_PRESS_UP, KEY_PRESS_DOWN,
+		KEY_PRESS_SPACE, KEY_PRESS_TAB, 0, 0
+	};
+	value = choices[m_generator.randInt(0, NUM_CHOICES - 1)];
+	return value != 0;
+}
@@ -0,0 +1,141 @@
+#ifndef HEADLESSCONTROLLER_H_
+#define HEADLESSCONTROLLER_H_
+
+#include "GameHost.h"
+#include "RandomGenerator.h"
+#include <string>
+
+class GameWorld;
+
+  // Totals from one HeadlessController::run.
+
+struct HeadlessStats
+{
+	long long ticks;
+	int levelsFinished;
+	int livesLost;
+	bool gameOver;
+};
+
+  // Drives a GameWorld through the same init/move/cleanUp sequence as
+  // GameController, but in a tight loop with no window, no frame timer and
+  // no sound device.  Keys come from an InputSource and sounds go to a
+  // SoundSink; either may be null, meaning no keys and silence.
+
+class HeadlessController : public GameHost
+{
+  public:
+	HeadlessController(InputSource* input = nullptr, SoundSink* sound = nullptr)
+	 : m_input(input), m_sound(sound), m_soundsPlayed(0), m_soundBatches(0),
+	   m_quit(false)
+	{
+	}
+
+	virtual ~HeadlessController()
+	{
+	}
+
+	virtual bool getLastKey(int& value)
+	{
+		return m_input != nullptr  &&  m_input->getLastKey(value);
+	}
+
+	virtual void takeTickInput(TickInput& input)
+	{
+		if (m_input != nullptr)
+			m_input->takeTickInput(input);
+		else
+			input.clear();
+	}
+
+	virtual void playSound(int soundID)
+	{
+		m_soundsPlayed++;
+		if (m_sound != nullptr)
+			m_sound->playSound(soundID);
+	}
+
+	virtual void playSounds(const SoundBatch& batch)
+	{
+		m_soundsPlayed += batch.numRequests();
+		m_soundBatches++;
+		if (m_sound != nullptr)
+			m_sound->playSounds(batch);
+	}
+
+	virtual void setGameStatText(const char* text)
+	{
+		m_gameStatText = text;
+	}
+
+	virtual void quitGame()
+	{
+		m_quit = true;
+	}
+
+	  // Run gw for at most maxTicks ticks, or until the game is over or a
+	  // 'q' key is consumed.  The world is cleaned up on return.
+	HeadlessStats run(GameWorld* gw, long long maxTicks);
+
+	const std::string& gameStatText() const
+	{
+		return m_gameStatText;
+	}
+
+	  // Every sound the world asked for, however they were coalesced
+	long long soundsPlayed() const
+	{
+		return m_soundsPlayed;
+	}
+
+	  // Ticks whose sounds were handed on together
+	long long soundBatches() const
+	{
+		return m_soundBatches;
+	}
+
+	bool quitRequested() const
+	{
+		return m_quit;
+	}
+
+  protected:
+	  // Called before each tick; returning false ends the run.
+	virtual bool beforeTick(GameWorld*)
+	{
+		return true;
+	}
+
+	  // Called after each tick with the status it returned.
+	virtual void afterTick(GameWorld*, int)
+	{
+	}
+
+  private:
+	InputSource* m_input;
+	SoundSink*	 m_sound;
+	long long	 m_soundsPlayed;
+	long long	 m_soundBatches;
+	bool		 m_quit;
+	std::string	 m_gameStatText;
+};
+
+  // Hits a random key (or nothing) on each request, like a very
+  // enthusiastic but untrained player.  Never hits 'q'.
+
+class RandomInputSource : public InputSource
+{
+  public:
+	RandomInputSource(std::uint64_t seed)
+	 : m_generator(seed)
+	{
+	}
+
+	virtual bool getLastKey(int& value);
+
+  private:
+	static const int NUM_CHOICES = 8;
+	RandomGenerator m_generator;
+};
+
+#endif // HEADLESSCONTROLLER_H_
@@ -0,0 +1,755 @@
+#include "HeadlessController.h"
+#include "GameWorld.h"
+#include "StudentWorld.h"
+#include "Actor.h"
+#include "Replay.h"
+#include "VecEnv.h"
+#include "SpriteMath.h"
+#include "AudioMixer.h"
+#include "AssetLoader.h"
+#include "AtlasLayout.h"
+#include "AllocationCounter.h"
+#include <iostream>
+#include <string>
+#include <cstdlib>
+#include <chrono>
+#include <iomanip>
+#include <algorithm>
+#include <limits>
+#include <vector>
+#include <thread>
+#include <cmath>
+using namespace std;
+
+  // Runs NachenBlaster with no window as fast as the CPU allows.
+  //
+  //   NachenBlasterHeadless [--ticks N] [--seed S] [--input-seed S]
+  //       Play random games back to back and report the tick rate.  Game
+  //       number k (counting from 0) is seeded with S+k, so the same seeds
+  //       always give the same games.
+  //   NachenBlasterHeadless --record FILE [--hashes] [--ticks N] [--seed S] [--input-seed S]
+  //       Play one random game and save it as a replay file, with a state
+  //       hash after every tick if --hashes is given.
+  //   NachenBlasterHeadless --replay FILE
+  //       Play a replay file back at full speed, checking the state hashes
+  //       if it has them.
+  //   NachenBlasterHeadless --bench-collision
+  //   NachenBlasterHeadless --bench-mass-death
+  //   NachenBlasterHeadless --bench-snapshot
+  //   NachenBlasterHeadless --bench-rotate
+  //   NachenBlasterHeadless --bench-vecenv [--envs N] [--threads T] [--ticks N]
+  //   NachenBlasterHeadless --bench-audio [--audio-out FILE] [--ticks N] [--seed S] [--input-seed S]
+  //   NachenBlasterHeadless --pack-assets DIR FILE
+  //       Build an asset pack in FILE from the loose sprites and sounds in
+  //       DIR.  The game uses DIR/assets.nbpack if it's there.
+  //   NachenBlasterHeadless --bench-startup DIR [--threads T]
+  //       Time getting the assets in DIR ready to hand to OpenGL and the
+  //       mixer, from the loose files and from DIR/assets.nbpack.
+
+static void usage(const char* argv0)
+{
+	cout << "usage: " << argv0 << " [--ticks N] [--seed S] [--input-seed S]" << endl;
+	cout << "       " << argv0 << " --record FILE [--hashes] [--ticks N] [--seed S] [--input-seed S]" << endl;
+	cout << "       " << argv0 << " --replay FILE" << endl;
+	cout << "       " << argv0 << " --bench-collision" << endl;
+	cout << "       " << argv0 << " --bench-mass-death" << endl;
+	cout << "       " << argv0 << " --bench-snapshot" << endl;
+	cout << "       " << argv0 << " --bench-rotate" << endl;
+	cout << "       " << argv0 << " --bench-vecenv [--envs N] [--threads T] [--ticks N]" << endl;
+	cout << "       " << argv0 << " --bench-audio [--audio-out FILE] [--ticks N] [--seed S] [--input-seed S]" << endl;
+	cout << "       " << argv0 << " --pack-assets DIR FILE" << endl;
+	cout << "       " << argv0 << " --bench-startup DIR [--threads T]" << endl;
+}
+
+  // Fill w with numActors actors laid out so that nothing collides with the
+  // player for the first few ticks: 40% stars, 20% aliens on the right half
+  // and 40% alien turnips flying left, all away from the player's row.
+
+static void populate(StudentWorld* w, int numActors, RandomGenerator& generator)
+{
+	for (int k = 0; k < numActors; k++)
+	{
+		double y = generator.randDouble(0, VIEW_HEIGHT / 2 - 30);
+		if (k % 2 == 0)
+			y = VIEW_HEIGHT - 1 - y;
+		switch (k % 5)
+		{
+			case 0: case 1:
+				w->spawnActor<Star>(generator.randDouble(0, VIEW_WIDTH - 1),
+								   generator.randDouble(0, VIEW_HEIGHT - 1), 0.2);
+				break;
+			case 2:
+				w->spawnActor<Smallgon>(generator.randDouble(VIEW_WIDTH / 2, VIEW_WIDTH - 1), y);
+				break;
+			default:
+				w->spawnActor<Turnip>(generator.randDouble(VIEW_WIDTH / 2, VIEW_WIDTH - 1), y);
+				break;
+		}
+	}
+}
+
+  // Ticks per second of StudentWorld::move with a crowded playfield.  Each
+  // round starts a fresh level, so the counts stay close to the nominal one.
+
+static void benchCollision()
+{
+	const int TICKS_PER_ROUND = 8;
+	const double MIN_SECONDS = 0.5;
+	const int counts[] = { 50, 100, 500, 1000, 5000, 10000, 50000 };
+
+	HeadlessController controller;
+	RandomGenerator generator(42);
+	cout << "   actors     ticks/s" << endl;
+	for (int numActors : counts)
+	{
+		StudentWorld world("");
+		world.setController(&controller);
+		long long ticks = 0;
+		chrono::duration<double> elapsed(0);
+		while (elapsed.count() < MIN_SECONDS)
+		{
+			world.init();
+			populate(&world, numActors, generator);
+			auto start = chrono::steady_clock::now();
+			for (int t = 0; t < TICKS_PER_ROUND; t++)
+			{
+				ticks++;
+				if (world.move() != GWSTATUS_CONTINUE_GAME)
+					break;
+			}
+			elapsed += chrono::steady_clock::now() - start;
+			world.cleanUp();
+		}
+		cout << setw(9) << numActors << setw(12)
+			 << static_cast<long long>(ticks / elapsed.count()) << endl;
+	}
+}
+
+  // Time of a tick in which numActors stars and turnips all leave the screen
+  // at once, half of them interleaved with survivors.
+
+static void benchMassDeath()
+{
+	const int ROUNDS = 5;
+	const int counts[] = { 1000, 5000, 10000, 50000 };
+
+	HeadlessController controller;
+	RandomGenerator generator(42);
+	cout << "   actors   ms/tick" << endl;
+	for (int numActors : counts)
+	{
+		StudentWorld world("");
+		world.setController(&controller);
+		chrono::duration<double> elapsed(0);
+		for (int r = 0; r < ROUNDS; r++)
+		{
+			world.init();
+			for (int k = 0; k < numActors; k++)
+			{
+				if (k % 4 == 3)  // survivor
+					world.spawnActor<Star>(VIEW_WIDTH / 2, generator.randDouble(0, VIEW_HEIGHT - 1), 0.2);
+				else if (k % 2 == 0)
+					world.spawnActor<Star>(-1, generator.randDouble(0, VIEW_HEIGHT - 1), 0.2);
+				else
+					world.spawnActor<Turnip>(0, generator.randDouble(0, VIEW_HEIGHT - 1));
+			}
+			auto start = chrono::steady_clock::now();
+			world.move();
+			elapsed += chrono::steady_clock::now() - start;
+			world.cleanUp();
+		}
+		cout << setw(9) << numActors << setw(10) << setprecision(3)
+			 << 1000 * elapsed.count() / ROUNDS << endl;
+	}
+}
+
+  // Play up to numTicks ticks of random input, stopping early if the player
+  // dies or finishes the level, and return the world's state hash.
+
+static uint64_t playFrom(StudentWorld* w, uint64_t inputSeed, int numTicks)
+{
+	RandomInputSource input(inputSeed);
+	HeadlessController controller(&input);
+	w->setController(&controller);
+	for (int t = 0; t < numTicks; t++)
+	{
+		if (w->tick() != GWSTATUS_CONTINUE_GAME)
+			break;
+	}
+	return w->stateHash();
+}
+
+  // Check that a restored snapshot plays on exactly like the original, then
+  // time saving and restoring snapshots of worlds of various sizes.
+
+static void benchSnapshot()
+{
+	const int ROUNDS = 2000;
+	const int counts[] = { 0, 100, 500, 1000 };
+
+	HeadlessController controller;
+	RandomGenerator generator(42);
+	vector<unsigned char> buffer;
+	cout << "   actors     bytes   save us  restore us  plays on" << endl;
+	for (int numActors : counts)
+	{
+		StudentWorld world("");
+		world.seedRandom(7);
+		world.setController(&controller);
+		world.init();
+		populate(&world, numActors, generator);
+		playFrom(&world, 1, 3);
+		world.saveSnapshot(buffer);
+		uint64_t savedHash = world.stateHash();
+		uint64_t original = playFrom(&world, 2, 200);
+
+		StudentWorld other("");
+		other.setController(&controller);
+		bool same = other.restoreSnapshot(buffer.data(), buffer.size())  &&
+					other.stateHash() == savedHash  &&
+					playFrom(&other, 2, 200) == original;
+
+		world.restoreSnapshot(buffer.data(), buffer.size());
+		world.setController(&controller);
+		auto start = chrono::steady_clock::now();
+		for (int r = 0; r < ROUNDS; r++)
+			world.saveSnapshot(buffer);
+		chrono::duration<double> saveTime = chrono::steady_clock::now() - start;
+		start = chrono::steady_clock::now();
+		for (int r = 0; r < ROUNDS; r++)
+			world.restoreSnapshot(buffer.data(), buffer.size());
+		chrono::duration<double> restoreTime = chrono::steady_clock::now() - start;
+		cout << setw(9) << numActors << setw(10) << buffer.size() << fixed
+			 << setprecision(2) << setw(10) << 1e6 * saveTime.count() / ROUNDS
+			 << setw(12) << 1e6 * restoreTime.count() / ROUNDS
+			 << setw(10) << (same ? "yes" : "NO") << defaultfloat << endl;
+		world.cleanUp();
+	}
+}
+
+  // How SpriteManager computed sprite corners before the sine/cosine
+  // table: sin and cos of the same angle for each corner.
+
+static void rotateWithLibm(double x, double y, double degrees, double& xout, double& yout)
+{
+	static const double PI = 4 * atan(1.0);
+	double theta = (degrees / 360.0) * (2 * PI);
+	xout = x * cos(theta) - y * sin(theta);
+	yout = y * cos(theta) + x * sin(theta);
+}
+
+  // Time computing the corners of 10,000 sprites with random directions and
+  // sizes both ways, and check that they agree.
+
+static void benchRotate()
+{
+	const int NUM_SPRITES = 10000;
+	const int ROUNDS = 200;
+
+	struct Sprite
+	{
+		double x, y, halfWidth, halfHeight;
+		int angle;
+	};
+	RandomGenerator generator(42);
+	vector<Sprite> sprites(NUM_SPRITES);
+	for (Sprite& sp : sprites)
+	{
+		sp.x = generator.randDouble(-4, 4);
+		sp.y = generator.randDouble(-4, 4);
+		sp.halfWidth = generator.randDouble(0.01, 0.5);
+		sp.halfHeight = sp.halfWidth;
+		sp.angle = generator.randInt(0, 359);
+	}
+	vector<float> oldCorners(NUM_SPRITES * 8);
+	vector<float> newCorners(NUM_SPRITES * 8);
+
+	auto start = chrono::steady_clock::now();
+	for (int r = 0; r < ROUNDS; r++)
+	{
+		float* out = oldCorners.data();
+		for (const Sprite& sp : sprites)
+		{
+			const double corners[4][2] = {
+				{ -sp.halfWidth, -sp.halfHeight }, { sp.halfWidth, -sp.halfHeight },
+				{ sp.halfWidth, sp.halfHeight }, { -sp.halfWidth, sp.halfHeight }
+			};
+			for (int k = 0; k < 4; k++)
+			{
+				double rx, ry;
+				rotateWithLibm(corners[k][0], corners[k][1], sp.angle, rx, ry);
+				out[k] = static_cast<float>(sp.x + rx);
+				out[4 + k] = static_cast<float>(sp.y + ry);
+			}
+			out += 8;
+		}
+	}
+	chrono::duration<double> oldTime = chrono::steady_clock::now() - start;
+
+	start = chrono::steady_clock::now();
+	for (int r = 0; r < ROUNDS; r++)
+	{
+		float* out = newCorners.data();
+		for (const Sprite& sp : sprites)
+		{
+			quadCorners(sp.x, sp.y, sp.halfWidth, sp.halfHeight, sp.angle, out, out + 4);
+			out += 8;
+		}
+	}
+	chrono::duration<double> newTime = chrono::steady_clock::now() - start;
+
+	double maxDifference = 0;
+	for (size_t k = 0; k < oldCorners.size(); k++)
+		maxDifference = max(maxDifference, static_cast<double>(fabs(oldCorners[k] - newCorners[k])));
+	double maxTableError = 0;
+	for (int d = 0; d < 360; d++)
+	{
+		double theta = d * (4 * atan(1.0)) / 180;
+		maxTableError = max(maxTableError, fabs(SIN_COS_TABLE.sinValue[d] - sin(theta)));
+		maxTableError = max(maxTableError, fabs(SIN_COS_TABLE.cosValue[d] - cos(theta)));
+	}
+
+	cout << NUM_SPRITES << " sprites: sin/cos per corner " << setprecision(3)
+		 << 1e6 * oldTime.count() / ROUNDS << " us, table + 4-wide corners "
+		 << 1e6 * newTime.count() / ROUNDS << " us" << endl;
+	cout << "largest corner difference " << maxDifference
+		 << ", largest table error " << maxTableError << endl;
+}
+
+  // Steps numEnvs worlds with random actions for numTicks ticks and reports
+  // the total number of world ticks per second.
+
+static void benchVecEnv(int numEnvs, int numThreads, long long numTicks)
+{
+	VecEnv env(numEnvs, numThreads, 1);
+	vector<int> actions(numEnvs);
+	vector<float> rewards(numEnvs);
+	vector<unsigned char> dones(numEnvs);
+	vector<float> observations(static_cast<size_t>(numEnvs) * OBS_SIZE);
+	RandomGenerator generator(42);
+
+	env.reset(observations.data());
+	double totalReward = 0;
+	long long episodes = 0;
+	auto start = chrono::steady_clock::now();
+	for (long long t = 0; t < numTicks; t++)
+	{
+		for (int& a : actions)
+			a = generator.randInt(0, NUM_ACTIONS - 1);
+		env.step(actions.data(), rewards.data(), dones.data(), observations.data());
+		for (int k = 0; k < numEnvs; k++)
+		{
+			totalReward += rewards[k];
+			episodes += dones[k];
+		}
+	}
+	chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+	cout << numEnvs << " worlds on " << numThreads << " threads: " << numTicks
+		 << " steps in " << elapsed.count() << " s ("
+		 << static_cast<long long>(numTicks * numEnvs / elapsed.count())
+		 << " world ticks/s), " << episodes << " episodes, total reward "
+		 << totalReward << endl;
+}
+
+  // Mixes a tick's worth of sound after every tick, as if the game were
+  // running at its usual rate with the mixer's thread keeping up.
+
+class AudioRenderController : public HeadlessController
+{
+  public:
+	static const int MS_PER_TICK = 15;
+
+	AudioRenderController(InputSource* input, AudioMixer* mixer)
+	 : HeadlessController(input, mixer), m_mixer(mixer), m_ticks(0)
+	{
+	}
+
+  protected:
+	virtual void afterTick(GameWorld*, int)
+	{
+		long long framesBefore = m_ticks * AUDIO_SAMPLE_RATE * MS_PER_TICK / 1000;
+		m_ticks++;
+		long long framesAfter = m_ticks * AUDIO_SAMPLE_RATE * MS_PER_TICK / 1000;
+		m_mixer->mix(static_cast<int>(framesAfter - framesBefore));
+	}
+
+  private:
+	AudioMixer* m_mixer;
+	long long	m_ticks;
+};
+
+  // Play a random game with every sound going through an AudioMixer (with
+  // made-up clips, since there may be no assets), mixing offline into a
+  // WAV file or nowhere.  Then time what a sound costs the tick thread and
+  // what mixing costs the mixing thread.
+
+static void benchAudio(string audioOut, long long maxTicks, uint64_t seed, uint64_t inputSeed)
+{
+	NullAudioSink nullSink;
+	WavFileSink* fileSink = audioOut.empty() ? nullptr : new WavFileSink(audioOut);
+	if (fileSink != nullptr  &&  !fileSink->isOpen())
+		cout << "Cannot create " << audioOut << endl;
+	AudioMixer mixer(fileSink != nullptr ? static_cast<AudioSink*>(fileSink) : &nullSink);
+
+	  // A decaying tone for each sound, higher and shorter as the ID goes up
+	for (int id = 0; id < NUM_SOUNDS; id++)
+	{
+		PcmClip clip;
+		int numFrames = AUDIO_SAMPLE_RATE * (id == SOUND_THEME ? 2000 : 400 - 30 * id) / 1000;
+		double hz = 220.0 * (1 + id);
+		for (int f = 0; f < numFrames; f++)
+		{
+			double t = static_cast<double>(f) / AUDIO_SAMPLE_RATE;
+			double v = 6000 * sin(2 * 3.14159265358979 * hz * t) * (1 - static_cast<double>(f) / numFrames);
+			for (int c = 0; c < AUDIO_CHANNELS; c++)
+				clip.samples.push_back(static_cast<int16_t>(v));
+		}
+		mixer.addClip(id, clip);
+	}
+
+	StudentWorld world("");
+	world.seedRandom(seed);
+	RandomInputSource input(inputSeed);
+	AudioRenderController controller(&input, &mixer);
+	HeadlessStats stats = controller.run(&world, maxTicks);
+	cout << stats.ticks << " ticks: " << controller.soundsPlayed() << " sounds in "
+		 << controller.soundBatches() << " batches, " << mixer.voicesStarted()
+		 << " voices started, " << mixer.soundsDropped() << " dropped";
+	if (fileSink != nullptr)
+		cout << ", written to " << audioOut;
+	cout << endl;
+	delete fileSink;
+
+	  // The tick thread's side: a swarm's worth of sounds in one tick, queued
+	  // one by one, or coalesced into a batch the way GameWorld does it
+	const int BURSTS = 2000;
+	const int SOUNDS_PER_BURST = 500;
+	AudioMixer timedMixer(&nullSink);
+	for (int id = 0; id < NUM_SOUNDS; id++)
+		timedMixer.addClip(id, PcmClip());
+	chrono::duration<double> playTime(0);
+	chrono::duration<double> batchTime(0);
+	SoundBatch batch;
+	unsigned long long allocationsBefore = globalAllocationCount();
+	for (int b = 0; b < BURSTS; b++)
+	{
+		auto start = chrono::steady_clock::now();
+		for (int k = 0; k < SOUNDS_PER_BURST; k++)
+			timedMixer.playSound(k % NUM_SOUNDS);
+		playTime += chrono::steady_clock::now() - start;
+		timedMixer.mix(0);
+
+		start = chrono::steady_clock::now();
+		for (int k = 0; k < SOUNDS_PER_BURST; k++)
+			batch.add(k % NUM_SOUNDS);
+		batch.finish();
+		timedMixer.playSounds(batch);
+		batch.clear();
+		batchTime += chrono::steady_clock::now() - start;
+		timedMixer.mix(0);
+	}
+	unsigned long long playAllocations = globalAllocationCount() - allocationsBefore;
+
+	  // The mixing thread's side: all voices busy, with a sound that has no
+	  // policy limiting its copies
+	const int UNLIMITED_SOUND = NUM_SOUNDS;
+	AudioMixer busyMixer(&nullSink);
+	PcmClip longClip;
+	longClip.samples.assign(static_cast<size_t>(AUDIO_SAMPLE_RATE) * AUDIO_CHANNELS * 20, 1000);
+	busyMixer.addClip(UNLIMITED_SOUND, longClip);
+	for (int v = 0; v < AudioMixer::MAX_VOICES; v++)
+		busyMixer.play(UNLIMITED_SOUND);
+	auto start = chrono::steady_clock::now();
+	busyMixer.mix(AUDIO_SAMPLE_RATE * 10);
+	chrono::duration<double> mixTime = chrono::steady_clock::now() - start;
+
+	cout << "a tick of " << SOUNDS_PER_BURST << " sounds: " << setprecision(3)
+		 << 1e6 * playTime.count() / BURSTS << " us queued one by one, "
+		 << 1e6 * batchTime.count() / BURSTS << " us as a batch, "
+		 << playAllocations << " allocations" << endl;
+	cout << "mixing " << AudioMixer::MAX_VOICES
+		 << " voices takes " << 1e3 * mixTime.count() / 10 << " ms per second of sound" << endl;
+}
+
+static int packAssets(string assetDir, string packPath)
+{
+	string error;
+	if (!writeAssetPack(assetDir, packPath, error))
+	{
+		cout << error << endl;
+		return 1;
+	}
+	AssetPack pack;
+	if (!pack.open(packPath))
+	{
+		cout << "Cannot read back " << packPath << endl;
+		return 1;
+	}
+	int pages = 0, sprites = 0, sounds = 0;
+	for (const AssetEntry& e : pack.entries())
+	{
+		pages += (e.kind == ASSET_ATLAS_PAGE);
+		sprites += (e.kind == ASSET_SPRITE);
+		sounds += (e.kind == ASSET_SOUND);
+	}
+	cout << packPath << ": " << pages << " atlas pages, " << sprites << " sprites, "
+		 << sounds << " sounds, " << pack.mappedSize() << " bytes" << endl;
+	return 0;
+}
+
+  // Time everything GameController does to the assets before the uploads,
+  // mipmaps included: from the loose files on one thread and on
+  // numThreads, and from the pack.  The first load of each shows the cost
+  // with a cold(er) cache; the best of the rest, with everything cached.
+
+static int benchStartup(string assetDir, int numThreads)
+{
+	const int RUNS = 20;
+	AssetPack pack;
+	struct Way
+	{
+		const char* name;
+		int			threads;
+		bool		packed;
+	} ways[] = {
+		{ "loose files", 1, false },
+		{ "loose files", numThreads, false },
+		{ ASSET_PACK_FILE, numThreads, true },
+	};
+	for (const Way& way : ways)
+	{
+		TaskPool pool(way.threads);
+		double firstMs = 0, bestMs = 0;
+		for (int run = 0; run < RUNS; run++)
+		{
+			auto start = chrono::steady_clock::now();
+			LoadedAssets assets;
+			string error;
+			bool ok = (!way.packed  ||  pack.open((assetDir.empty() ? "" : assetDir + '/') + ASSET_PACK_FILE))  &&
+					  loadAssets(assetDir, way.packed ? &pack : nullptr, MAX_ATLAS_SIZE, true, pool, assets, error);
+			chrono::duration<double, milli> elapsed = chrono::steady_clock::now() - start;
+			if (!ok)
+			{
+				cout << "Cannot load " << way.name << " from " << assetDir << ": " << error << endl;
+				return 1;
+			}
+			if (run == 0)
+				firstMs = bestMs = elapsed.count();
+			bestMs = min(bestMs, elapsed.count());
+		}
+		cout << way.name << ", " << pool.numThreads() << " threads: first " << firstMs
+			 << " ms, best of " << RUNS << " " << bestMs << " ms" << endl;
+	}
+	return 0;
+}
+
+  // Plays a replay back, checking after every tick that the world is in the
+  // state it was in when the replay was recorded.
+
+class ReplayController : public HeadlessController
+{
+  public:
+	ReplayController(ReplayPlayer* replay)
+	 : HeadlessController(replay), m_replay(replay), m_firstDivergence(-1),
+	   m_ticks(0)
+	{
+	}
+
+	long long firstDivergence() const
+	{
+		return m_firstDivergence;
+	}
+
+  protected:
+	virtual bool beforeTick(GameWorld*)
+	{
+		return m_replay->beginTick();
+	}
+
+	virtual void afterTick(GameWorld* gw, int)
+	{
+		if (m_firstDivergence < 0  &&  !m_replay->hashMatches(gw->stateHash()))
+			m_firstDivergence = m_ticks;
+		m_ticks++;
+	}
+
+  private:
+	ReplayPlayer* m_replay;
+	long long	  m_firstDivergence;
+	long long	  m_ticks;
+};
+
+static int record(string path, bool withHashes, long long maxTicks, uint64_t seed, uint64_t inputSeed)
+{
+	StudentWorld world("");
+	world.seedRandom(seed);
+	ReplayRecorder recorder;
+	if (!recorder.open(path, seed, world.getLevel(), withHashes))
+	{
+		cout << "Cannot create " << path << endl;
+		return 1;
+	}
+	world.setRecorder(&recorder);
+	RandomInputSource input(inputSeed);
+	HeadlessController controller(&input);
+	HeadlessStats stats = controller.run(&world, maxTicks);
+	recorder.close();
+	cout << "recorded " << stats.ticks << " ticks, " << stats.levelsFinished
+		 << " levels finished, final score " << world.getScore() << endl;
+	return 0;
+}
+
+static int replay(string path)
+{
+	ReplayPlayer player;
+	if (!player.open(path))
+	{
+		cout << "Cannot read replay file " << path << endl;
+		return 1;
+	}
+	StudentWorld world("");
+	world.seedRandom(player.seed());
+	while (world.getLevel() < player.level())
+		world.advanceToNextLevel();
+	ReplayController controller(&player);
+	auto start = chrono::steady_clock::now();
+	HeadlessStats stats = controller.run(&world, numeric_limits<long long>::max());
+	chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+	cout << "replayed " << stats.ticks << " ticks in " << elapsed.count() << " s ("
+		 << static_cast<long long>(stats.ticks / elapsed.count()) << " ticks/s), "
+		 << stats.levelsFinished << " levels finished, final score "
+		 << world.getScore() << endl;
+	if (controller.firstDivergence() >= 0)
+	{
+		cout << "DIVERGED at tick " << controller.firstDivergence() << endl;
+		return 2;
+	}
+	if (player.hasHashes())
+		cout << "all state hashes match" << endl;
+	return 0;
+}
+
+int main(int argc, char* argv[])
+{
+	long long maxTicks = -1;  // depends on the mode
+	uint64_t seed = 1;
+	uint64_t inputSeed = 1;
+	string recordPath;
+	bool withHashes = false;
+	bool vecEnv = false;
+	bool audio = false;
+	string audioOut;
+	string startupAssetDir;
+	int numEnvs = 64;
+	int numThreads = max(1u, thread::hardware_concurrency());
+
+	for (int k = 1; k < argc; k++)
+	{
+		string arg = argv[k];
+		if (arg == "--ticks"  &&  k+1 < argc)
+			maxTicks = atoll(argv[++k]);
+		else if (arg == "--seed"  &&  k+1 < argc)
+			seed = strtoull(argv[++k], nullptr, 10);
+		else if (arg == "--input-seed"  &&  k+1 < argc)
+			inputSeed = strtoull(argv[++k], nullptr, 10);
+		else if (arg == "--record"  &&  k+1 < argc)
+			recordPath = argv[++k];
+		else if (arg == "--hashes")
+			withHashes = true;
+		else if (arg == "--replay"  &&  k+1 < argc)
+			return replay(argv[++k]);
+		else if (arg == "--bench-rotate")
+		{
+			benchRotate();
+			return 0;
+		}
+		else if (arg == "--bench-vecenv")
+			vecEnv = true;
+		else if (arg == "--bench-audio")
+			audio = true;
+		else if (arg == "--audio-out"  &&  k+1 < argc)
+			audioOut = argv[++k];
+		else if (arg == "--envs"  &&  k+1 < argc)
+			numEnvs = atoi(argv[++k]);
+		else if (arg == "--threads"  &&  k+1 < argc)
+			numThreads = atoi(argv[++k]);
+		else if (arg == "--bench-collision")
+		{
+			benchCollision();
+			return 0;
+		}
+		else if (arg == "--bench-snapshot")
+		{
+			benchSnapshot();
+			return 0;
+		}
+		else if (arg == "--pack-assets"  &&  k+2 < argc)
+		{
+			string assetDir = argv[++k];
+			return packAssets(assetDir, argv[++k]);
+		}
+		else if (arg == "--bench-startup"  &&  k+1 < argc)
+			startupAssetDir = argv[++k];
+		else if (arg == "--bench-mass-death")
+		{
+			benchMassDeath();
+			return 0;
+		}
+		else
+		{
+			usage(argv[0]);
+			return 1;
+		}
+	}
+
+	if (vecEnv)
+	{
+		benchVecEnv(numEnvs, numThreads, maxTicks < 0 ? 2000 : maxTicks);
+		return 0;
+	}
+	if (!startupAssetDir.empty())
+		return benchStartup(startupAssetDir, numThreads);
+	if (audio)
+	{
+		benchAudio(audioOut, maxTicks < 0 ? 20000 : maxTicks, seed, inputSeed);
+		return 0;
+	}
+	if (maxTicks < 0)
+		maxTicks = 1000000;
+	if (!recordPath.empty())
+		return record(recordPath, withHashes, maxTicks, seed, inputSeed);
+
+	RandomInputSource input(inputSeed);
+	HeadlessController controller(&input);
+
+	long long ticks = 0;
+	int games = 0;
+	int levels = 0;
+	unsigned long poolAllocations = 0;
+	unsigned int finalScore = 0;
+	unsigned long long allocationsBefore = globalAllocationCount();
+	auto start = chrono::steady_clock::now();
+	while (ticks < maxTicks  &&  !controller.quitRequested())
+	{
+		StudentWorld* gw = new StudentWorld("");
+		gw->seedRandom(seed + games);
+		HeadlessStats stats = controller.run(gw, maxTicks - ticks);
+		poolAllocations += gw->actorPoolAllocations();
+		finalScore = gw->getScore();
+		delete gw;
+		ticks += stats.ticks;
+		levels += stats.levelsFinished;
+		games++;
+	}
+	chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+	unsigned long long allocations = globalAllocationCount() - allocationsBefore;
+
+	cout << ticks << " ticks in " << elapsed.count() << " s ("
+		 << static_cast<long long>(ticks / elapsed.count()) << " ticks/s), "
+		 << games << " games, " << levels << " levels finished, "
+		 << controller.soundsPlayed() << " sounds, final score "
+		 << finalScore << endl;
+	cout << "global allocations: " << allocations << " ("
+		 << static_cast<double>(allocations) / ticks << " per tick), "
+		 << poolAllocations << " by actor pools" << endl;
+}
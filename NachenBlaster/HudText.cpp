@@ -0,0 +1,93 @@
+#include "HudText.h"
+#include <cstring>
+using namespace std;
+
+// Each field is a label and a number, each right-aligned in its own width,
+// laid out the way iostreams' setw would, e.g.,
+// "    Lives: 3  Health:  100%   Score:     0 Level:  1 Cabbages:  100% Torpedoes:  0"
+struct HudField
+{
+    const char* label;
+    int labelWidth;
+    int valueWidth;
+    const char* suffix;
+};
+
+static const HudField FIELDS[] = {
+    { "Lives:", 10, 2, "" },
+    { "Health:", 9, 5, "%" },
+    { "Score:", 9, 6, "" },
+    { "Level:", 7, 3, "" },
+    { "Cabbages:", 10, 5, "%" },
+    { "Torpedoes:", 11, 3, "" },
+};
+
+HudText::HudText()
+{
+    for (int i = 0; i < NUM_FIELDS; i++) {
+        m_values[i] = 0;
+    }
+    m_valid = false;
+    m_text[0] = '\0';
+    m_length = 0;
+}
+
+bool HudText::update(long long lives, long long healthPct, long long score,
+                     long long level, long long cabbagePct, long long torpedoes)
+{
+    const long long values[NUM_FIELDS] = { lives, healthPct, score, level, cabbagePct, torpedoes };
+    if (m_valid && memcmp(values, m_values, sizeof(values)) == 0) {
+        return false;
+    }
+    memcpy(m_values, values, sizeof(values));
+    m_valid = true;
+    format();
+    return true;
+}
+
+void HudText::invalidate()
+{
+    m_valid = false;
+}
+
+const char* HudText::text() const
+{
+    return m_text;
+}
+
+void HudText::format()
+{
+    m_length = 0;
+    for (int i = 0; i < NUM_FIELDS; i++) {
+        const HudField& f = FIELDS[i];
+        appendRightAligned(f.label, static_cast<int>(strlen(f.label)), f.labelWidth);
+        appendNumber(m_values[i], f.valueWidth);
+        appendRightAligned(f.suffix, static_cast<int>(strlen(f.suffix)), 0);
+    }
+    m_text[m_length] = '\0';
+}
+
+void HudText::appendRightAligned(const char* s, int len, int width)
+{
+    for (int pad = width - len; pad > 0 && m_length < MAX_LENGTH; pad--) {
+        m_text[m_length++] = ' ';
+    }
+    for (int i = 0; i < len && m_length < MAX_LENGTH; i++) {
+        m_text[m_length++] = s[i];
+    }
+}
+
+void HudText::appendNumber(long long v, int width)
+{
+    char digits[24];
+    int n = sizeof(digits);
+    unsigned long long u = v < 0 ? 0ULL - static_cast<unsigned long long>(v) : v;
+    do {  //fill from the end, least significant digit first
+        digits[--n] = static_cast<char>('0' + u % 10);
+        u /= 10;
+    } while (u != 0);
+    if (v < 0) {
+        digits[--n] = '-';
+    }
+    appendRightAligned(digits + n, static_cast<int>(sizeof(digits)) - n, width);
+}
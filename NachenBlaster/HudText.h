@@ -0,0 +1,29 @@
+#ifndef HUDTEXT_H_
+#define HUDTEXT_H_
+
+// The status line across the top of the screen.  The numbers in it are
+// kept as integers and the text is only reformatted, into a fixed buffer,
+// when one of them changes, so updating it every tick never allocates.
+class HudText
+{
+public:
+    HudText();
+    // Set the numbers shown; returns true if that changed the text.
+    bool update(long long lives, long long healthPct, long long score,
+                long long level, long long cabbagePct, long long torpedoes);
+    // Make the next update report a change even if nothing changed.
+    void invalidate();
+    const char* text() const;
+private:
+    static const int NUM_FIELDS = 6;
+    static const int MAX_LENGTH = 255;  //far more than six fields can need
+    long long m_values[NUM_FIELDS];
+    bool m_valid;
+    char m_text[MAX_LENGTH + 1];
+    int m_length;
+    void format();
+    void appendRightAligned(const char* s, int len, int width);
+    void appendNumber(long long v, int width);
+};
+
+#endif // HUDTEXT_H_
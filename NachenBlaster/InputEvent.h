@@ -0,0 +1,17 @@
+#ifndef INPUTEVENT_H_
+#define INPUTEVENT_H_
+
+#include <chrono>
+
+  // A key going down or coming up, stamped with when it happened.  Events
+  // that come from somewhere other than a keyboard (a replay, an agent)
+  // have no time.
+
+struct InputEvent
+{
+	int		key;
+	bool	pressed;
+	std::chrono::steady_clock::time_point time;
+};
+
+#endif // INPUTEVENT_H_
@@ -0,0 +1,83 @@
+#ifndef LATENCYHISTOGRAM_H_
+#define LATENCYHISTOGRAM_H_
+
+#include <vector>
+#include <ostream>
+#include <string>
+
+  // Counts latencies in buckets a tenth of a millisecond wide, for reading
+  // off percentiles.  Anything over MAX_MS goes in one last bucket.  Adding
+  // a sample never allocates.
+
+class LatencyHistogram
+{
+  public:
+	static const int BUCKETS_PER_MS = 10;
+	static const int MAX_MS = 500;
+
+	LatencyHistogram()
+	 : m_counts(MAX_MS * BUCKETS_PER_MS + 1, 0), m_count(0), m_maxMs(0)
+	{
+	}
+
+	void add(double ms)
+	{
+		if (ms < 0)
+			ms = 0;
+		int bucket = static_cast<int>(ms * BUCKETS_PER_MS);
+		if (bucket >= static_cast<int>(m_counts.size()))
+			bucket = static_cast<int>(m_counts.size()) - 1;
+		m_counts[bucket]++;
+		m_count++;
+		if (ms > m_maxMs)
+			m_maxMs = ms;
+	}
+
+	long long count() const
+	{
+		return m_count;
+	}
+
+	double maxMs() const
+	{
+		return m_maxMs;
+	}
+
+	  // The latency that percent percent of the samples are at or under, to
+	  // the resolution of a bucket (or MAX_MS, if it's in the last one)
+	double percentile(double percent) const
+	{
+		if (m_count == 0)
+			return 0;
+		long long needed = static_cast<long long>(percent / 100 * m_count + .999999);
+		if (needed < 1)
+			needed = 1;
+		long long seen = 0;
+		for (std::size_t k = 0; k < m_counts.size(); k++)
+		{
+			seen += m_counts[k];
+			if (seen >= needed)
+				return k + 1 == m_counts.size() ? MAX_MS : static_cast<double>(k + 1) / BUCKETS_PER_MS;
+		}
+		return MAX_MS;
+	}
+
+	  // e.g., "key to screen: 41 samples, p50 23.4 ms, p95 31 ms, p99 33.2 ms, max 33.17 ms"
+	void print(std::ostream& os, std::string what) const
+	{
+		os << what << ": " << m_count << " samples";
+		if (m_count > 0)
+		{
+			os << ", p50 " << percentile(50) << " ms, p95 " << percentile(95)
+			   << " ms, p99 " << percentile(99) << " ms, max " << m_maxMs << " ms";
+		}
+		os << std::endl;
+	}
+
+  private:
+	std::vector<long long> m_counts;
+	long long			   m_count;
+	double				   m_maxMs;
+};
+
+#endif // LATENCYHISTOGRAM_H_
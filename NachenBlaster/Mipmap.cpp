@@ -0,0 +1,98 @@
+#include "Mipmap.h"
+#include <algorithm>
+#if defined(__SSE2__)  ||  defined(_M_X64)  ||  (defined(_M_IX86_FP)  &&  _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define NB_MIPMAP_SSE2
+#elif defined(__ARM_NEON)  ||  defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define NB_MIPMAP_NEON
+#endif
+using namespace std;
+
+void MipChain::reset(int width, int height, const char* level0, int maxLevel)
+{
+	m_width = width;
+	m_height = height;
+	m_levels.assign(1, level0);
+	m_storage.clear();
+	for (int level = 1; level <= maxLevel  &&  (width > 1  ||  height > 1); level++)
+	{
+		width = max(width / 2, 1);
+		height = max(height / 2, 1);
+		m_storage.push_back(vector<char>(static_cast<size_t>(width) * height * 4));
+	}
+	for (vector<char>& s : m_storage)
+		m_levels.push_back(s.data());
+}
+
+  // Average the 2x2 blocks of two source rows into dstWidth pixels, as many
+  // at a time as the CPU allows; return how many pixels were done.  Each
+  // channel comes out as (a + b + c + d + 2) / 4, exactly as the scalar
+  // code below would have it.
+
+static int averageRowsSimd(const unsigned char* r0, const unsigned char* r1, unsigned char* out, int dstWidth)
+{
+	int x = 0;
+#if defined(NB_MIPMAP_SSE2)
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i two = _mm_set1_epi16(2);
+	for ( ; x + 2 <= dstWidth; x += 2)
+	{
+		__m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(r0 + 8*x));
+		__m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(r1 + 8*x));
+		  // Sum down the columns of source pixels 0 and 1, then 2 and 3 ...
+		__m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+		__m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+		  // ... then across each pair
+		lo = _mm_add_epi16(lo, _mm_srli_si128(lo, 8));
+		hi = _mm_add_epi16(hi, _mm_srli_si128(hi, 8));
+		__m128i sum = _mm_srli_epi16(_mm_add_epi16(_mm_unpacklo_epi64(lo, hi), two), 2);
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(out + 4*x), _mm_packus_epi16(sum, sum));
+	}
+#elif defined(NB_MIPMAP_NEON)
+	for ( ; x + 8 <= dstWidth; x += 8)
+	{
+		  // Sixteen source pixels a row, split by channel
+		uint8x16x4_t a = vld4q_u8(r0 + 8*x);
+		uint8x16x4_t b = vld4q_u8(r1 + 8*x);
+		uint8x8x4_t result;
+		for (int c = 0; c < 4; c++)
+			result.val[c] = vrshrn_n_u16(vaddq_u16(vpaddlq_u8(a.val[c]), vpaddlq_u8(b.val[c])), 2);
+		vst4_u8(out + 4*x, result);
+	}
+#else
+	(void) r0; (void) r1; (void) out; (void) dstWidth;
+#endif
+	return x;
+}
+
+void MipChain::buildRows(int level, int rowBegin, int rowEnd)
+{
+	int srcWidth = width(level - 1);
+	int srcHeight = height(level - 1);
+	int dstWidth = width(level);
+	const unsigned char* src = reinterpret_cast<const unsigned char*>(m_levels[level - 1]);
+	unsigned char* dst = reinterpret_cast<unsigned char*>(m_storage[level - 1].data());
+
+	for (int y = rowBegin; y < rowEnd; y++)
+	{
+		  // A side already down to 1 pixel is averaged with itself
+		const unsigned char* r0 = src + 4 * static_cast<size_t>(2*y) * srcWidth;
+		const unsigned char* r1 = src + 4 * static_cast<size_t>(min(2*y + 1, srcHeight - 1)) * srcWidth;
+		unsigned char* out = dst + 4 * static_cast<size_t>(y) * dstWidth;
+		int x = (srcWidth > 1 ? averageRowsSimd(r0, r1, out, dstWidth) : 0);
+		for ( ; x < dstWidth; x++)
+		{
+			int x0 = 2*x;
+			int x1 = min(2*x + 1, srcWidth - 1);
+			for (int c = 0; c < 4; c++)
+				out[4*x + c] = static_cast<unsigned char>((r0[4*x0 + c] + r0[4*x1 + c] + r1[4*x0 + c] + r1[4*x1 + c] + 2) / 4);
+		}
+	}
+}
+
+void MipChain::build()
+{
+	for (int level = 1; level < numLevels(); level++)
+		buildRows(level, 0, height(level));
+}
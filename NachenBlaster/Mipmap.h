@@ -0,0 +1,61 @@
+#ifndef MIPMAP_H_
+#define MIPMAP_H_
+
+#include <vector>
+
+  // A BGRA texture's images from full size down to 1x1 (or as far as
+  // asked), each half the size of the one before (rounding down, but never
+  // below 1), made by
+  // averaging 2x2 blocks.  The full-size image isn't copied; it must
+  // outlive the chain.  Levels can be built a band of rows at a time, so
+  // several threads can share the work of one level.
+
+class MipChain
+{
+  public:
+	MipChain()
+	 : m_width(0), m_height(0)
+	{
+	}
+
+	  // Start a chain on level 0, with room for levels 1 through maxLevel
+	  // below it (fewer if they reach 1x1 first; none if maxLevel is 0).
+	void reset(int width, int height, const char* level0, int maxLevel);
+
+	int numLevels() const
+	{
+		return static_cast<int>(m_levels.size());
+	}
+
+	int width(int level) const
+	{
+		int w = m_width >> level;
+		return w < 1 ? 1 : w;
+	}
+
+	int height(int level) const
+	{
+		int h = m_height >> level;
+		return h < 1 ? 1 : h;
+	}
+
+	const char* level(int level) const
+	{
+		return m_levels[level];
+	}
+
+	  // Fill rows [rowBegin, rowEnd) of level (at least 1) from the level
+	  // above it, which must be complete.
+	void buildRows(int level, int rowBegin, int rowEnd);
+
+	  // Build every level on this thread
+	void build();
+
+  private:
+	int						m_width;
+	int						m_height;
+	std::vector<const char*> m_levels;
+	std::vector<std::vector<char>> m_storage;	// levels 1 and down
+};
+
+#endif // MIPMAP_H_
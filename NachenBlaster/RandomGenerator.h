@@ -0,0 +1,116 @@
+#ifndef RANDOMGENERATOR_H_
+#define RANDOMGENERATOR_H_
+
+#include <cstdint>
+#include <utility>
+
+  // Independent streams of random numbers each GameWorld hands out.  Every
+  // subsystem draws from its own stream, so that (for instance) the HUD
+  // flickering differently can never change how a game plays out.
+
+const int RNG_SPAWN	= 0;	// stars, aliens and goodie drops
+const int RNG_AI	= 1;	// alien flight plans and attacks
+const int RNG_HUD	= 2;	// purely cosmetic effects
+const int NUM_RNG_STREAMS = 3;
+
+  // A small, fast generator (O'Neill's PCG32, XSH-RR variant) with 16 bytes
+  // of state.  The same seed and stream always produce the same sequence on
+  // every platform.
+
+class RandomGenerator
+{
+  public:
+	RandomGenerator(std::uint64_t seed = 0, std::uint64_t stream = 0)
+	{
+		reseed(seed, stream);
+	}
+
+	void reseed(std::uint64_t seed, std::uint64_t stream)
+	{
+		m_state = 0;
+		m_inc = (stream << 1) | 1;
+		next();
+		m_state += seed;
+		next();
+	}
+
+	  // The generator's entire state, for saving and restoring it
+
+	void getState(std::uint64_t& state, std::uint64_t& inc) const
+	{
+		state = m_state;
+		inc = m_inc;
+	}
+
+	void setState(std::uint64_t state, std::uint64_t inc)
+	{
+		m_state = state;
+		m_inc = inc;
+	}
+
+	  // Return the next 32 uniformly distributed random bits
+
+	std::uint32_t next()
+	{
+		std::uint64_t old = m_state;
+		m_state = old * 6364136223846793005ULL + m_inc;
+		std::uint32_t xorShifted = static_cast<std::uint32_t>(((old >> 18) ^ old) >> 27);
+		std::uint32_t rot = static_cast<std::uint32_t>(old >> 59);
+		return (xorShifted >> rot) | (xorShifted << ((32 - rot) & 31));
+	}
+
+	  // Return a uniformly distributed random int from min to max, inclusive
+
+	int randInt(int min, int max)
+	{
+		if (max < min)
+			std::swap(max, min);
+		std::uint32_t range = static_cast<std::uint32_t>(max) - static_cast<std::uint32_t>(min) + 1;
+		if (range == 0)  // the full range of int
+			return static_cast<int>(next());
+		return static_cast<int>(static_cast<std::uint32_t>(min) + bounded(range));
+	}
+
+	  // Return a uniformly distributed random double in [min, max)
+
+	double randDouble(double min, double max)
+	{
+		if (max < min)
+			std::swap(max, min);
+		return min + unitDouble() * (max - min);
+	}
+
+	  // Return a uniformly distributed random double in [0, 1) with 53
+	  // random bits
+
+	double unitDouble()
+	{
+		std::uint32_t high = next() >> 5;
+		std::uint32_t low = next() >> 6;
+		return (high * 67108864.0 + low) * (1.0 / 9007199254740992.0);
+	}
+
+  private:
+	std::uint64_t m_state;
+	std::uint64_t m_inc;
+
+	  // Lemire's multiply-and-reject method: unbiased, and almost never
+	  // needs a division.
+	std::uint32_t bounded(std::uint32_t range)
+	{
+		std::uint64_t m = static_cast<std::uint64_t>(next()) * range;
+		std::uint32_t low = static_cast<std::uint32_t>(m);
+		if (low < range)
+		{
+			std::uint32_t threshold = (0u - range) % range;
+			while (low < threshold)
+			{
+				m = static_cast<std::uint64_t>(next()) * range;
+				low = static_cast<std::uint32_t>(m);
+			}
+		}
+		return static_cast<std::uint32_t>(m >> 32);
+	}
+};
+
+#endif // RANDOMGENERATOR_H_
@@ -0,0 +1,201 @@
+#include "Replay.h"
+#include <iterator>
+#include <algorithm>
+using namespace std;
+
+static const char REPLAY_MAGIC[4] = { 'N', 'B', 'R', 'P' };
+static const int MAX_KEYS_PER_TICK = 0x7f;
+static const int MAX_EMPTY_RUN = 0x80;
+static const size_t FLUSH_SIZE = 64 * 1024;
+
+static void putBytes(vector<unsigned char>& buffer, uint64_t value, int n)
+{
+	for (int k = 0; k < n; k++)
+		buffer.push_back(static_cast<unsigned char>(value >> (8 * k)));
+}
+
+ReplayRecorder::ReplayRecorder()
+ : m_pendingEmptyTicks(0), m_withHashes(false)
+{
+	m_buffer.reserve(FLUSH_SIZE + 1024);
+	m_keys.reserve(MAX_KEYS_PER_TICK);
+}
+
+ReplayRecorder::~ReplayRecorder()
+{
+	close();
+}
+
+bool ReplayRecorder::open(string path, uint64_t seed, unsigned int level, bool withHashes)
+{
+	close();
+	m_file.open(path, ios::out | ios::binary | ios::trunc);
+	if (!m_file)
+		return false;
+	m_withHashes = withHashes;
+	m_pendingEmptyTicks = 0;
+	m_keys.clear();
+	m_buffer.insert(m_buffer.end(), REPLAY_MAGIC, REPLAY_MAGIC + 4);
+	putBytes(m_buffer, REPLAY_VERSION, 2);
+	putBytes(m_buffer, withHashes ? REPLAY_HAS_HASHES : 0, 2);
+	putBytes(m_buffer, seed, 8);
+	putBytes(m_buffer, level, 4);
+	return true;
+}
+
+void ReplayRecorder::recordKey(int key)
+{
+	if (m_keys.size() < MAX_KEYS_PER_TICK)
+		m_keys.push_back(key);
+}
+
+void ReplayRecorder::endTick(uint64_t stateHash)
+{
+	if (!m_file.is_open())
+		return;
+	if (m_keys.empty()  &&  !m_withHashes)
+	{
+		if (++m_pendingEmptyTicks == MAX_EMPTY_RUN)
+			flushEmptyTicks();
+		return;
+	}
+	flushEmptyTicks();
+	m_buffer.push_back(static_cast<unsigned char>(m_keys.size()));
+	for (int key : m_keys)
+		putBytes(m_buffer, static_cast<uint16_t>(key), 2);
+	if (m_withHashes)
+		putBytes(m_buffer, stateHash, 8);
+	m_keys.clear();
+	if (m_buffer.size() >= FLUSH_SIZE)
+		flushBuffer();
+}
+
+void ReplayRecorder::close()
+{
+	if (!m_file.is_open())
+		return;
+	flushEmptyTicks();
+	flushBuffer();
+	m_file.close();
+}
+
+void ReplayRecorder::flushEmptyTicks()
+{
+	if (m_pendingEmptyTicks > 0)
+	{
+		m_buffer.push_back(static_cast<unsigned char>(0x80 + m_pendingEmptyTicks - 1));
+		m_pendingEmptyTicks = 0;
+	}
+}
+
+void ReplayRecorder::flushBuffer()
+{
+	m_file.write(reinterpret_cast<const char*>(m_buffer.data()), m_buffer.size());
+	m_buffer.clear();
+}
+
+ReplayPlayer::ReplayPlayer()
+ : m_pos(0), m_seed(0), m_level(1), m_withHashes(false), m_emptyTicksLeft(0),
+   m_nextKey(0), m_expectedHash(0)
+{
+	m_tickKeys.reserve(MAX_KEYS_PER_TICK);
+}
+
+bool ReplayPlayer::open(string path)
+{
+	ifstream file(path, ios::in | ios::binary);
+	if (!file)
+		return false;
+	m_data.assign(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+	m_pos = 0;
+	m_emptyTicksLeft = 0;
+	m_tickKeys.clear();
+	m_nextKey = 0;
+
+	if (m_data.size() < 4  ||  !equal(REPLAY_MAGIC, REPLAY_MAGIC + 4, m_data.begin()))
+		return false;
+	m_pos = 4;
+	uint64_t version, flags, seed, level;
+	if (!readBytes(2, version)  ||  version != REPLAY_VERSION  ||
+		!readBytes(2, flags)  ||  !readBytes(8, seed)  ||  !readBytes(4, level))
+		return false;
+	m_withHashes = (flags & REPLAY_HAS_HASHES) != 0;
+	m_seed = seed;
+	m_level = static_cast<unsigned int>(level);
+	return true;
+}
+
+bool ReplayPlayer::beginTick()
+{
+	m_tickKeys.clear();
+	m_nextKey = 0;
+	if (m_emptyTicksLeft > 0)
+	{
+		m_emptyTicksLeft--;
+		return true;
+	}
+	uint64_t b;
+	if (!readBytes(1, b))
+		return false;
+	if (b >= 0x80)
+	{
+		m_emptyTicksLeft = static_cast<int>(b - 0x80);
+		return true;
+	}
+	for (uint64_t k = 0; k < b; k++)
+	{
+		uint64_t key;
+		if (!readBytes(2, key))
+			return false;
+		m_tickKeys.push_back(static_cast<int>(key));
+	}
+	if (m_withHashes  &&  !readBytes(8, m_expectedHash))
+		return false;
+	return true;
+}
+
+bool ReplayPlayer::hashMatches(uint64_t h) const
+{
+	return !m_withHashes  ||  h == m_expectedHash;
+}
+
+bool ReplayPlayer::getLastKey(int& value)
+{
+	while (m_nextKey < m_tickKeys.size())
+	{
+		int key = m_tickKeys[m_nextKey++];
+		if ((key & REPLAY_HELD_KEYS) == 0)
+		{
+			value = key;
+			return true;
+		}
+	}
+	return false;
+}
+
+void ReplayPlayer::takeTickInput(TickInput& input)
+{
+	input.clear();
+	for ( ; m_nextKey < m_tickKeys.size(); m_nextKey++)
+	{
+		int key = m_tickKeys[m_nextKey];
+		if (key & REPLAY_HELD_KEYS)
+			input.heldKeys |= key & ~REPLAY_HELD_KEYS;
+		else
+		{
+			InputEvent e = { key, true, chrono::steady_clock::time_point() };
+			input.addPress(e);
+		}
+	}
+}
+
+bool ReplayPlayer::readBytes(int n, uint64_t& value)
+{
+	if (m_pos + n > m_data.size())
+		return false;
+	value = 0;
+	for (int k = 0; k < n; k++)
+		value |= static_cast<uint64_t>(m_data[m_pos + k]) << (8 * k);
+	m_pos += n;
+	return true;
+}
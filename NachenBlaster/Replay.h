@@ -0,0 +1,108 @@
+#ifndef REPLAY_H_
+#define REPLAY_H_
+
+#include "GameHost.h"
+#include <string>
+#include <vector>
+#include <fstream>
+#include <cstdint>
+
+  // A replay file holds everything needed to play a game over exactly: the
+  // random seed, the starting level, and every key the world consumed on
+  // every tick.  All numbers are little-endian.
+  //
+  //   header:  "NBRP"  uint16 version  uint16 flags  uint64 seed  uint32 level
+  //   ticks:   one record per call to GameWorld::tick()
+  //
+  // A tick record starts with a byte b.  If b < 0x80, b keys (uint16 each)
+  // follow, then, if the REPLAY_HAS_HASHES flag is set, the uint64
+  // GameWorld::stateHash() after the tick.  If b >= 0x80 (only possible
+  // without hashes), the record stands for (b - 0x80 + 1) ticks in a row in
+  // which no keys were consumed.
+  //
+  // A key with the REPLAY_HELD_KEYS bit set isn't a key but the HELD_* bits
+  // of the keys held down during the tick (see GameWorld::drainInput).
+
+const int REPLAY_VERSION = 1;
+const int REPLAY_HAS_HASHES = 1;
+const int REPLAY_HELD_KEYS = 0x8000;
+
+class ReplayRecorder
+{
+  public:
+	ReplayRecorder();
+	~ReplayRecorder();
+
+	  // Start a new replay file; returns false if it can't be created.
+	bool open(std::string path, std::uint64_t seed, unsigned int level, bool withHashes);
+	bool isOpen() const
+	{
+		return m_file.is_open();
+	}
+	void recordKey(int key);
+	void endTick(std::uint64_t stateHash);
+	void close();
+
+  private:
+	std::ofstream m_file;
+	std::vector<unsigned char> m_buffer;
+	std::vector<int> m_keys;		// consumed so far this tick
+	int			  m_pendingEmptyTicks;
+	bool		  m_withHashes;
+
+	void flushEmptyTicks();
+	void flushBuffer();
+};
+
+  // Feeds the keys of a replay file back to a world one tick at a time.
+
+class ReplayPlayer : public InputSource
+{
+  public:
+	ReplayPlayer();
+
+	  // Read a whole replay file into memory; returns false if it can't be
+	  // read or isn't a replay file.
+	bool open(std::string path);
+
+	std::uint64_t seed() const
+	{
+		return m_seed;
+	}
+
+	unsigned int level() const
+	{
+		return m_level;
+	}
+
+	bool hasHashes() const
+	{
+		return m_withHashes;
+	}
+
+	  // Move on to the next tick's keys; returns false if there are no more
+	  // ticks in the replay.
+	bool beginTick();
+
+	  // If the replay has hashes, is h the hash recorded for the current
+	  // tick?  (Always true if it has none.)
+	bool hashMatches(std::uint64_t h) const;
+
+	virtual bool getLastKey(int& value);
+	virtual void takeTickInput(TickInput& input);
+
+  private:
+	std::vector<unsigned char> m_data;
+	std::size_t	  m_pos;
+	std::uint64_t m_seed;
+	unsigned int  m_level;
+	bool		  m_withHashes;
+	int			  m_emptyTicksLeft;
+	std::vector<int> m_tickKeys;	// the keys of the current tick
+	std::size_t	  m_nextKey;
+	std::uint64_t m_expectedHash;
+
+	bool readBytes(int n, std::uint64_t& value);
+};
+
+#endif // REPLAY_H_
@@ -0,0 +1,134 @@
+#ifndef SOUNDBATCH_H_
+#define SOUNDBATCH_H_
+
+#include "GameConstants.h"
+
+  // How a sound competes for the mixer's voices: when they're all busy, a
+  // sound may cut off one of lower or equal priority, and no more than
+  // maxVoices copies of it ever play at once (another one restarts the
+  // oldest copy instead).
+
+struct SoundPolicy
+{
+	int priority;
+	int maxVoices;
+};
+
+inline const SoundPolicy& soundPolicy(int soundID)
+{
+	static const SoundPolicy policies[NUM_SOUNDS] = {
+		{ 3, 1 },	// SOUND_THEME
+		{ 2, 2 },	// SOUND_GOODIE
+		{ 1, 4 },	// SOUND_BLAST
+		{ 2, 2 },	// SOUND_PLAYER_SHOOT
+		{ 0, 3 },	// SOUND_ALIEN_SHOOT
+		{ 3, 2 },	// SOUND_DEATH
+		{ 3, 1 },	// SOUND_FINISHED_LEVEL
+		{ 1, 2 },	// SOUND_TORPEDO
+	};
+	return policies[soundID];
+}
+
+  // The sounds asked for during one tick.  Asking for a sound already in
+  // the batch just counts it, so however many times a swarm of aliens
+  // blows up, the batch holds each sound once and costs O(distinct sounds)
+  // to hand on.  Once finished, the sounds are in order of priority,
+  // highest first.  SOUND_NONE throws away what was asked for before it
+  // and stops whatever is playing.
+
+class SoundBatch
+{
+  public:
+	SoundBatch()
+	 : m_numDistinct(0), m_numRequests(0), m_stopFirst(false)
+	{
+		for (int id = 0; id < NUM_SOUNDS; id++)
+			m_counts[id] = 0;
+	}
+
+	void add(int soundID)
+	{
+		if (soundID == SOUND_NONE)
+		{
+			clearSounds();
+			m_stopFirst = true;
+			m_numRequests++;
+			return;
+		}
+		if (soundID < 0  ||  soundID >= NUM_SOUNDS)
+			return;
+		if (m_counts[soundID]++ == 0)
+			m_ids[m_numDistinct++] = soundID;
+		m_numRequests++;
+	}
+
+	  // Sort the sounds by priority; stable, so ties stay in the order they
+	  // were first asked for
+	void finish()
+	{
+		for (int k = 1; k < m_numDistinct; k++)
+		{
+			int id = m_ids[k];
+			int j = k;
+			for ( ; j > 0  &&  soundPolicy(m_ids[j-1]).priority < soundPolicy(id).priority; j--)
+				m_ids[j] = m_ids[j-1];
+			m_ids[j] = id;
+		}
+	}
+
+	void clear()
+	{
+		clearSounds();
+		m_numRequests = 0;
+		m_stopFirst = false;
+	}
+
+	bool empty() const
+	{
+		return m_numRequests == 0;
+	}
+
+	  // Should whatever is playing be stopped before these sounds start?
+	bool stopsFirst() const
+	{
+		return m_stopFirst;
+	}
+
+	int size() const
+	{
+		return m_numDistinct;
+	}
+
+	int soundID(int k) const
+	{
+		return m_ids[k];
+	}
+
+	  // How many times the k'th sound was asked for
+	int count(int k) const
+	{
+		return m_counts[m_ids[k]];
+	}
+
+	  // How many times any sound (or SOUND_NONE) was asked for
+	int numRequests() const
+	{
+		return m_numRequests;
+	}
+
+  private:
+	int		m_counts[NUM_SOUNDS];
+	int		m_ids[NUM_SOUNDS];
+	int		m_numDistinct;
+	int		m_numRequests;
+	bool	m_stopFirst;
+
+	void clearSounds()
+	{
+		for (int k = 0; k < m_numDistinct; k++)
+			m_counts[m_ids[k]] = 0;
+		m_numDistinct = 0;
+	}
+};
+
+#endif // SOUNDBATCH_H_
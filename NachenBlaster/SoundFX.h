@@ -3,6 +3,9 @@
 
 #include <string>
 
+  // Plays sound clips on the platform's sound device.  Each GameController
+  // owns one; there is no process-wide instance.
+
 #if defined(_MSC_VER)
 
 #include "irrKlang/irrKlang.h"
@@ -25,11 +28,6 @@ class SoundFXController
 			m_engine->stopAllSounds();
 	}
 
-	static SoundFXController& getInstance();
-
-  private:
-	irrklang::ISoundEngine* m_engine;
-
 	SoundFXController()
 	{
 		m_engine = irrklang::createIrrKlangDevice();
@@ -44,6 +42,9 @@ class SoundFXController
 			m_engine->drop();
 	}
 
+  private:
+	irrklang::ISoundEngine* m_engine;
+
 	SoundFXController(const SoundFXController&);
 	SoundFXController& operator=(const SoundFXController&);
 };
@@ -68,7 +69,6 @@ class SoundFXController
 	void playClip(std::string soundFile)
 	{
 		  // Don't start a clip more than 2 times per second
-		static std::chrono::system_clock::time_point lastPlayTime;
 		auto now = std::chrono::system_clock::now();
 		if (now - lastPlayTime < std::chrono::milliseconds(500))
 			return;
@@ -89,12 +89,11 @@ class SoundFXController
 			kill(pid, SIGINT);
 		pidValid = false;
 	}
-	
-	static SoundFXController& getInstance();
 
   private:
 	pid_t pid;
 	bool pidValid;
+	std::chrono::system_clock::time_point lastPlayTime;
 };
 
 #else  // forget about sound
@@ -104,21 +103,8 @@ class SoundFXController
   public:
 	void playClip(std::string) {}
 	void abortClip() {}
-	static SoundFXController& getInstance();
 };
 
 #endif
 
-  // Meyers singleton pattern
-inline SoundFXController& SoundFXController::getInstance()
-{
-	static SoundFXController instance;
-	return instance;
-}
-
-inline SoundFXController& SoundFX()
-{
-	return SoundFXController::getInstance();
-}
-
 #endif // SOUNDFX_H_
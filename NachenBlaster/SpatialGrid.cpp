@@ -0,0 +1,114 @@
+#include "SpatialGrid.h"
+#include "Actor.h"
+#include <cmath>
+using namespace std;
+
+SpatialGrid::SpatialGrid()
+{
+    m_maxRadius = 0;
+}
+
+void SpatialGrid::insert(Actor* a, unsigned long serial)
+{
+    int cell = cellOf(a->getX(), a->getY());
+    Entry e = { a, serial, a->getX(), a->getY(), a->getRadius() };
+    m_cells[cell].push_back(e);
+    a->setGridCell(cell);
+    if (e.radius > m_maxRadius) {
+        m_maxRadius = e.radius;
+    }
+}
+
+void SpatialGrid::update(Actor* a)
+{
+    int oldCell = a->gridCell();
+    if (oldCell < 0) {  //not in the grid
+        return;
+    }
+    int newCell = cellOf(a->getX(), a->getY());
+    vector<Entry>& entries = m_cells[oldCell];
+    for (size_t i = 0; i < entries.size(); i++) {
+        if (entries[i].actor == a) {
+            entries[i].x = a->getX();
+            entries[i].y = a->getY();
+            if (newCell != oldCell) {  //move the entry to its new cell
+                m_cells[newCell].push_back(entries[i]);
+                entries[i] = entries.back();
+                entries.pop_back();
+                a->setGridCell(newCell);
+            }
+            return;
+        }
+    }
+}
+
+void SpatialGrid::remove(Actor* a)
+{
+    int cell = a->gridCell();
+    if (cell < 0) {
+        return;
+    }
+    vector<Entry>& entries = m_cells[cell];
+    for (size_t i = 0; i < entries.size(); i++) {
+        if (entries[i].actor == a) {
+            entries[i] = entries.back();
+            entries.pop_back();
+            break;
+        }
+    }
+    a->setGridCell(-1);
+}
+
+void SpatialGrid::clear()
+{
+    for (int i = 0; i < GRID_COLS * GRID_ROWS; i++) {
+        for (size_t j = 0; j < m_cells[i].size(); j++) {
+            m_cells[i][j].actor->setGridCell(-1);
+        }
+        m_cells[i].clear();  //keeps capacity for the next level
+    }
+}
+
+Actor* SpatialGrid::findOverlapping(double x, double y, double r, double factor) const
+{
+    double reach = factor * (r + m_maxRadius);
+    int minCol = clampedCol(x - reach);
+    int maxCol = clampedCol(x + reach);
+    int minRow = clampedRow(y - reach);
+    int maxRow = clampedRow(y + reach);
+    const Entry* best = nullptr;
+    for (int row = minRow; row <= maxRow; row++) {
+        for (int col = minCol; col <= maxCol; col++) {
+            const vector<Entry>& entries = m_cells[row * GRID_COLS + col];
+            for (size_t i = 0; i < entries.size(); i++) {
+                const Entry& e = entries[i];
+                if (best != nullptr && e.serial > best->serial) {
+                    continue;
+                }
+                double dx = x - e.x;
+                double dy = y - e.y;
+                if (sqrt(dx * dx + dy * dy) < factor * (r + e.radius)) {
+                    best = &e;
+                }
+            }
+        }
+    }
+    return best == nullptr ? nullptr : best->actor;
+}
+
+int SpatialGrid::cellOf(double x, double y)
+{
+    return clampedRow(y) * GRID_COLS + clampedCol(x);
+}
+
+int SpatialGrid::clampedCol(double x)
+{
+    int col = static_cast<int>(floor(x / GRID_CELL_SIZE));
+    return col < 0 ? 0 : (col >= GRID_COLS ? GRID_COLS - 1 : col);
+}
+
+int SpatialGrid::clampedRow(double y)
+{
+    int row = static_cast<int>(floor(y / GRID_CELL_SIZE));
+    return row < 0 ? 0 : (row >= GRID_ROWS ? GRID_ROWS - 1 : row);
+}
@@ -0,0 +1,52 @@
+#ifndef SPATIALGRID_H_
+#define SPATIALGRID_H_
+
+#include "GameConstants.h"
+#include <vector>
+
+class Actor;
+
+// Uniform grid over the playfield used to find actors near a point without
+// looking at every actor in the world.  Cells are as wide as a size-1.0
+// actor, so a collision query only ever touches a handful of cells.  Actors
+// outside the playfield (aliens may stray off the top or bottom for a bit)
+// are kept in the nearest edge cell.
+const int GRID_CELL_SIZE = 16;
+const int GRID_COLS = (VIEW_WIDTH + GRID_CELL_SIZE - 1) / GRID_CELL_SIZE;
+const int GRID_ROWS = (VIEW_HEIGHT + GRID_CELL_SIZE - 1) / GRID_CELL_SIZE;
+
+class SpatialGrid
+{
+public:
+    // What a cell remembers about each actor in it.  The position and radius
+    // are copied here so a query never has to chase the actor pointer.
+    struct Entry
+    {
+        Actor* actor;
+        unsigned long serial;
+        double x;
+        double y;
+        double radius;
+    };
+    SpatialGrid();
+    // Add a to the grid.  Among several actors matching a query, the one
+    // with the lowest serial wins.
+    void insert(Actor* a, unsigned long serial);
+    // a has moved; update its cell and cached position.
+    void update(Actor* a);
+    // Take a out of the grid.
+    void remove(Actor* a);
+    // Empty the grid.
+    void clear();
+    // Return the actor with the lowest serial whose center is closer than
+    // factor * (r + its radius) to (x, y), or a null pointer if there is none.
+    Actor* findOverlapping(double x, double y, double r, double factor) const;
+private:
+    std::vector<Entry> m_cells[GRID_COLS * GRID_ROWS];
+    double m_maxRadius;
+    static int cellOf(double x, double y);
+    static int clampedCol(double x);
+    static int clampedRow(double y);
+};
+
+#endif // SPATIALGRID_H_
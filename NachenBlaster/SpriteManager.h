@@ -11,11 +11,26 @@
 #define GL_BGRA GL_BGRA_EXT
 #endif
 
+#ifndef GL_CLAMP_TO_EDGE
+#define GL_CLAMP_TO_EDGE 0x812F
+#endif
+
+#ifndef GL_TEXTURE_MAX_LEVEL
+#define GL_TEXTURE_MAX_LEVEL 0x813D
+#endif
+
 #include "GameConstants.h"
+#include "SpriteMath.h"
+#include "AtlasLayout.h"
+#include "AssetLoader.h"
+#include "Mipmap.h"
 #include <iostream>
 #include <fstream>
 #include <string>
 #include <map>
+#include <vector>
+#include <algorithm>
+#include <utility>
 #include <cmath>
 
 static const double VISIBLE_MIN_X = -2.39;
@@ -39,101 +54,41 @@ public:
 		m_mipMapped = status;
 	}
 
-	bool loadSprite(std::string filename_tga, int imageID, int frameNum)
+	bool mipMapping() const
 	{
-		  // Load Texture Data From TGA File
-
-		int spriteID = getSpriteID(imageID, frameNum);
-		if (INVALID_SPRITE_ID == spriteID)
-			return false;
-
-		m_frameCountPerSprite[imageID]++;	// keep track of how many frames per sprite we loaded
-
-		std::string line;
-		std::string contents = "";
-		std::ifstream tgaFile(filename_tga, std::ios::in|std::ios::binary);
-
-		if (!tgaFile)
-			return false;
-
-		char type[3];
-		char info[6];
-
-		  // Read file header info
-		tgaFile.read(type, 3);
-		tgaFile.seekg(12);
-		tgaFile.read(info, 6);
-		unsigned int textureWidth = static_cast<unsigned char>(info[0]) + static_cast<unsigned char>(info[1]) * 256;
-		unsigned int textureHeight = static_cast<unsigned char>(info[2]) + static_cast<unsigned char>(info[3]) * 256;
-		unsigned char byteCount = static_cast<unsigned char>(info[4]) / 8;
-		long imageSize = textureWidth * textureHeight * byteCount;
-		char* imageData = new char[imageSize];
-		tgaFile.seekg(18);
-		  // Read image data
-		tgaFile.read(imageData, imageSize);
-		if (!tgaFile)
-		{
-			delete [] imageData;
-			return false;
-		}
-
-		  //image type either 2 (color) or 3 (greyscale)
-		if (type[1] != 0 || (type[2] != 2 && type[2] != 3))
-			return false;
-
-		if (byteCount != 3 && byteCount != 4)
-			return false;
-
-		  // Transfer Texture To OpenGL
-
-		glEnable(GL_DEPTH_TEST);
-
-		  // allocate a texture handle
-		GLuint glTextureID;
-		glGenTextures(1, &glTextureID);
-
-		  // bind our new texture
-		glBindTexture(GL_TEXTURE_2D, glTextureID);
-
-		glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+		return m_mipMapped;
+	}
 
-		if (m_mipMapped)
-		{
-			  // when texture area is small, bilinear filter the closest mipmap
-			glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-			  // when texture area is large, bilinear filter the first mipmap
-			glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-		}
-		else
-		{
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-		}
+	  // The biggest atlas page this OpenGL can take
+	static int maxAtlasSize()
+	{
+		GLint size = 0;
+		glGetIntegerv(GL_MAX_TEXTURE_SIZE, &size);
+		return std::min(static_cast<int>(size), MAX_ATLAS_SIZE);
+	}
 
-		  // Have the texture wrap both vertically and horizontally.
-		glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, static_cast<GLfloat>(GL_REPEAT));
-		glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, static_cast<GLfloat>(GL_REPEAT));
+	  // Take sprites loaded by loadAssets (built with this manager's
+	  // mipMapping() and maxAtlasSize()), uploading each page and its
+	  // mipmaps as they are: the only work left for the GL thread.
 
-		if (m_mipMapped)
+	void addLoadedAssets(const LoadedAssets& assets)
+	{
+		std::vector<GLuint> textures;
+		for (const LoadedPage& page : assets.pages)
 		{
-			  // build our texture mipmaps
-			  // byteCount of 3 means that BGR data is being supplied. byteCount of 4 means that BGRA data is being supplied.
-            makeMipmaps(byteCount, textureWidth, textureHeight, imageData);
+			textures.push_back(uploadTexture(page.mips));
+			m_atlasTextures.push_back(textures.back());
 		}
-		else
+		for (const LoadedSprite& s : assets.sprites)
 		{
-			  // byteCount of 3 means that BGR data is being supplied. byteCount of 4 means that BGRA data is being supplied.
-			if (3 == byteCount)
-				glTexImage2D(GL_TEXTURE_2D, 0, 3, textureWidth, textureHeight, 0, GL_BGR, GL_UNSIGNED_BYTE, imageData);
-			else if (4 == byteCount)
-				glTexImage2D(GL_TEXTURE_2D, 0, 4, textureWidth, textureHeight, 0, GL_BGRA, GL_UNSIGNED_BYTE, imageData);
+			int spriteID = getSpriteID(s.imageID, s.frameNum);
+			if (INVALID_SPRITE_ID == spriteID)
+				continue;
+			m_frameCountPerSprite[s.imageID]++;
+			const LoadedPage& page = assets.pages[s.page];
+			AtlasPageSize size = { page.width, page.height };
+			setAtlasRect(spriteID, textures[s.page], size, s.x, s.y, s.width, s.height);
 		}
-
-		delete [] imageData;
-
-		m_imageMap[spriteID] = glTextureID;
-
-		return true;
 	}
 
 	int getNumFrames(int imageID) const
@@ -145,7 +100,21 @@ public:
 		return it->second;
 	}
 
-	bool plotSprite(int imageID, int frame, double x, double y, int angleDegrees, double size)
+	  // Batched drawing.  Between beginBatch and endBatch, queueSprite only
+	  // works out where a sprite's corners go.  endBatch then sets up the GL
+	  // state once and draws everything queued with one glDrawArrays per
+	  // depth and texture, deepest first, so sprites of one depth that share
+	  // a texture go down together.  Only OpenGL 1.1 vertex arrays are used,
+	  // so this runs on any driver, Mesa's software rasterizer included.
+
+	void beginBatch()
+	{
+		for (int depth = 0; depth < NUM_BATCH_DEPTHS; depth++)
+			for (auto& batch : m_batches[depth])
+				batch.vertices.clear();
+	}
+
+	bool queueSprite(int imageID, int frame, double x, double y, int angleDegrees, double size, int depth)
 	{
 		int spriteID = getSpriteID(imageID, frame);
 		if (INVALID_SPRITE_ID == spriteID)
@@ -155,93 +124,64 @@ public:
 		if (it == m_imageMap.end())
 			return false;
 
-		glPushMatrix();
+		if (depth < 0  ||  depth >= NUM_BATCH_DEPTHS)
+			depth = 0;
+		const AtlasRect& r = it->second;
+		std::vector<SpriteVertex>& vertices = batchFor(depth, r.texture);
 
-		double finalWidth, finalHeight;
+		double finalWidth = SPRITE_WIDTH_GL * size;
+		double finalHeight = SPRITE_HEIGHT_GL * size;
 
-		finalWidth = SPRITE_WIDTH_GL * size;
-		finalHeight = SPRITE_HEIGHT_GL * size;
+		double gx, gy, gz;
+		convertToGlutCoords(x, y, gx, gy, gz);
 
-		// object's x/y location is center-based, but sprite plotting is upper-left-corner based
-		const double xoffset = 0;// finalWidth / 2;
-		const double yoffset = 0;// finalHeight / 2;
+		const GLfloat texCoords[4][2] = { { r.u0, r.v0 }, { r.u1, r.v0 }, { r.u1, r.v1 }, { r.u0, r.v1 } };
+		float xs[4], ys[4];
+		quadCorners(gx, gy, finalWidth/2, finalHeight/2, angleDegrees, xs, ys);
+		for (int k = 0; k < 4; k++)
+		{
+			SpriteVertex v = {
+				texCoords[k][0], texCoords[k][1], xs[k], ys[k], static_cast<GLfloat>(gz)
+			};
+			vertices.push_back(v);
+		}
+		return true;
+	}
 
-        double gx, gy, gz;
-        convertToGlutCoords(x, y, gx, gy, gz);
-		glTranslatef(static_cast<GLfloat>(gx-xoffset),static_cast<GLfloat>(gy-yoffset),static_cast<GLfloat>(gz));
-		glPushAttrib(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	void endBatch()
+	{
+		glPushAttrib(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_ENABLE_BIT | GL_CURRENT_BIT);
+		glPushClientAttrib(GL_CLIENT_VERTEX_ARRAY_BIT);
 		glEnable(GL_TEXTURE_2D);
 		glDisable(GL_DEPTH_TEST);
-		glEnable (GL_BLEND);
+		glEnable(GL_BLEND);
 		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-		glBindTexture(GL_TEXTURE_2D, it->second);
-
 		glColor3f(1.0, 1.0, 1.0);
 
-		double cx1,cx2,cx3,cx4;
-		double cy1,cy2,cy3,cy4;
-
-		cx1 = cy1 = 0;
-		cx2 = 1; cy2 = 0;
-		cx3 = 1; cy3 = 1;
-		cx4 = 0; cy4 = 1;
-
-		double rx1, ry1, rx2, ry2, rx3, ry3, rx4, ry4;
-		rotate(-finalWidth/2, -finalHeight/2, angleDegrees, rx1, ry1);
-		rotate(finalWidth/2, -finalHeight/2, angleDegrees, rx2, ry2);
-		rotate(finalWidth/2, finalHeight/2, angleDegrees, rx3, ry3);
-		rotate(-finalWidth/2, finalHeight/2, angleDegrees, rx4, ry4);
-
-		glBegin(GL_QUADS);
-		glTexCoord2d(cx1, cy1);
-		glVertex3f(static_cast<GLfloat>(rx1), static_cast<GLfloat>(ry1), 0);
-		glTexCoord2d(cx2, cy2);
-		glVertex3f(static_cast<GLfloat>(rx2), static_cast<GLfloat>(ry2), 0);
-		glTexCoord2d(cx3, cy3);
-		glVertex3f(static_cast<GLfloat>(rx3), static_cast<GLfloat>(ry3), 0);
-		glTexCoord2d(cx4, cy4);
-		glVertex3f(static_cast<GLfloat>(rx4), static_cast<GLfloat>(ry4), 0);
-		glEnd();
-
-
-		/*
-		glBegin (GL_QUADS);
-		  glTexCoord2d(cx1, cy1);
-		  glVertex3f(0, 0, 0);
-		  glTexCoord2d(cx2, cy2);
-		  glVertex3f(static_cast<GLfloat>(finalWidth), 0, 0);
-		  glTexCoord2d(cx3, cy3);
-		  glVertex3f(static_cast<GLfloat>(finalWidth), static_cast<GLfloat>(finalHeight), 0);
-		  glTexCoord2d(cx4, cy4);
-		  glVertex3f(0, static_cast<GLfloat>(finalHeight), 0);
-		glEnd();
-		*/
-
-		glDisable(GL_TEXTURE_2D);
-		glEnable(GL_DEPTH_TEST);
+		for (int depth = NUM_BATCH_DEPTHS - 1; depth >= 0; depth--)
+		{
+			for (const auto& batch : m_batches[depth])
+			{
+				if (batch.vertices.empty())
+					continue;
+				glBindTexture(GL_TEXTURE_2D, batch.texture);
+				glInterleavedArrays(GL_T2F_V3F, 0, batch.vertices.data());
+				glDrawArrays(GL_QUADS, 0, static_cast<GLsizei>(batch.vertices.size()));
+			}
+		}
 
+		glPopClientAttrib();
 		glPopAttrib();
-		glPopMatrix();
-
-		return true;
 	}
 
 	~SpriteManager()
 	{
-		for (auto it = m_imageMap.begin(); it != m_imageMap.end(); it++)
-			glDeleteTextures(1, &it->second);
+		for (GLuint texture : m_atlasTextures)
+			glDeleteTextures(1, &texture);
 	}
 
 private:
 
-	static void rotate(double x, double y, double degrees, double& xout, double& yout)
-	{
-        static const double PI = 4 * atan(1.0);
-		double theta = (degrees / 360.0) * (2 * PI);
-		xout = x * cos(theta) - y * sin(theta);
-		yout = y * cos(theta) + x * sin(theta);
-	}
-    
     static void convertToGlutCoords(double x, double y, double& gx, double& gy, double& gz)
     {
         x /= VIEW_WIDTH;
@@ -251,14 +191,51 @@ private:
         gz = .6 * VISIBLE_MIN_Z;
     }
 
+	  // Laid out as GL_T2F_V3F
+	struct SpriteVertex
+	{
+		GLfloat s, t;
+		GLfloat x, y, z;
+	};
+
+	struct Batch
+	{
+		GLuint texture;
+		std::vector<SpriteVertex> vertices;
+	};
+
+	static const int NUM_BATCH_DEPTHS = 4;
+
+	  // Where a sprite lives: which atlas texture, and the corners of its
+	  // image within it
+	struct AtlasRect
+	{
+		GLuint texture;
+		GLfloat u0, v0, u1, v1;
+	};
+
 	bool					m_mipMapped;
-	std::map<int, GLuint>	m_imageMap;
+	std::map<int, AtlasRect> m_imageMap;
 	std::map<int, int>		m_frameCountPerSprite;
+	std::vector<GLuint>		m_atlasTextures;
+	std::vector<Batch>		m_batches[NUM_BATCH_DEPTHS];	// kept between frames to reuse their storage
 
 	static const int INVALID_SPRITE_ID = -1;
 	static const int MAX_IMAGES = 1000;
 	static const int MAX_FRAMES_PER_SPRITE = 100;
 
+	std::vector<SpriteVertex>& batchFor(int depth, GLuint texture)
+	{
+		for (auto& batch : m_batches[depth])
+		{
+			if (batch.texture == texture)
+				return batch.vertices;
+		}
+		m_batches[depth].push_back(Batch());
+		m_batches[depth].back().texture = texture;
+		return m_batches[depth].back().vertices;
+	}
+
 	int getSpriteID(int imageID, int frame) const
 	{
 		if (imageID >= MAX_IMAGES || frame >= MAX_FRAMES_PER_SPRITE)
@@ -267,17 +244,63 @@ private:
 		return imageID * MAX_FRAMES_PER_SPRITE + frame;
 	}
     
-    void makeMipmaps(unsigned char byteCount, unsigned int textureWidth, unsigned int textureHeight, char* imageData)
-    {
-        int format = (byteCount == 3 ? GL_BGR : GL_BGRA);
-#ifdef __APPLE__
-        int internalFormat = (byteCount == 3 ? GL_RGB : GL_RGBA);
-        glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, textureWidth, textureHeight, 0, format, GL_UNSIGNED_BYTE, imageData);
-        glGenerateMipmap(GL_TEXTURE_2D);
-#else
-        gluBuild2DMipmaps(GL_TEXTURE_2D, byteCount, textureWidth, textureHeight, format, GL_UNSIGNED_BYTE, imageData);
-#endif
-    }
+	void setAtlasRect(int spriteID, GLuint texture, const AtlasPageSize& page, int x, int y, int width, int height)
+	{
+		AtlasRect& r = m_imageMap[spriteID];
+		r.texture = texture;
+		r.u0 = static_cast<GLfloat>(x) / page.width;
+		r.v0 = static_cast<GLfloat>(y) / page.height;
+		r.u1 = static_cast<GLfloat>(x + width) / page.width;
+		r.v1 = static_cast<GLfloat>(y + height) / page.height;
+	}
+
+	  // Send a texture to OpenGL with whatever levels mips has: just the one
+	  // if it isn't mipmapped, or down to ATLAS_MAX_MIP_LEVEL if it is.
+
+	GLuint uploadTexture(const MipChain& mips)
+	{
+		  // Transfer Texture To OpenGL
+
+		glEnable(GL_DEPTH_TEST);
+
+		  // allocate a texture handle
+		GLuint glTextureID;
+		glGenTextures(1, &glTextureID);
+
+		  // bind our new texture
+		glBindTexture(GL_TEXTURE_2D, glTextureID);
+
+		glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+
+		if (mips.numLevels() > 1)
+		{
+			  // when texture area is small, bilinear filter the closest mipmap
+			glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+			  // when texture area is large, bilinear filter the first mipmap
+			glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		}
+		else
+		{
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		}
+
+		  // Sprites sit side by side in the atlas, so nothing may wrap around.
+		glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, static_cast<GLfloat>(GL_CLAMP_TO_EDGE));
+		glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, static_cast<GLfloat>(GL_CLAMP_TO_EDGE));
+
+		  // The mipmaps were built ahead of time, off this thread, by
+		  // loadAssets.  Any deeper would let sprites bleed into each other,
+		  // so the chain stops short of 1x1, and GL has to be told where.
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, mips.numLevels() - 1);
+		for (int level = 0; level < mips.numLevels(); level++)
+		{
+			glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA, mips.width(level), mips.height(level), 0,
+						 GL_BGRA, GL_UNSIGNED_BYTE, mips.level(level));
+		}
+
+		return glTextureID;
+	}
 };
 
 #endif // SPRITEMANAGER_H_
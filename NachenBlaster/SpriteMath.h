@@ -0,0 +1,112 @@
+#ifndef SPRITEMATH_H_
+#define SPRITEMATH_H_
+
+#if defined(__SSE2__)  ||  defined(_M_X64)  ||  (defined(_M_IX86_FP)  &&  _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SPRITEMATH_SSE2
+#endif
+
+  // Geometry for drawing sprites, kept free of OpenGL so that it can be
+  // tested and timed without a window.
+  //
+  // GraphObject directions are whole degrees from 0 to 359, so sines and
+  // cosines come from a table computed by the compiler rather than from
+  // calls to sin and cos.
+
+namespace SpriteMathDetail
+{
+	const double PI = 3.14159265358979323846;
+
+	  // Taylor series, accurate to the last bit of a double for |x| <= pi/4
+	constexpr double taylorSin(double x)
+	{
+		double term = x;
+		double sum = x;
+		for (int n = 1; n < 12; n++)
+		{
+			term *= -x * x / ((2*n) * (2*n + 1));
+			sum += term;
+		}
+		return sum;
+	}
+
+	constexpr double taylorCos(double x)
+	{
+		double term = 1;
+		double sum = 1;
+		for (int n = 1; n < 12; n++)
+		{
+			term *= -x * x / ((2*n - 1) * (2*n));
+			sum += term;
+		}
+		return sum;
+	}
+
+	  // sin of degrees in [0, 360), reduced to the first octant
+	constexpr double sinDegrees(int degrees)
+	{
+		return degrees >= 180 ? -sinDegrees(degrees - 180) :
+			   degrees > 90 ? sinDegrees(180 - degrees) :
+			   degrees > 45 ? taylorCos((90 - degrees) * PI / 180) :
+			   taylorSin(degrees * PI / 180);
+	}
+}
+
+struct SinCosTable
+{
+	double sinValue[360];
+	double cosValue[360];
+
+	constexpr SinCosTable()
+	 : sinValue(), cosValue()
+	{
+		for (int d = 0; d < 360; d++)
+		{
+			sinValue[d] = SpriteMathDetail::sinDegrees(d);
+			cosValue[d] = SpriteMathDetail::sinDegrees((d + 90) % 360);
+		}
+	}
+};
+
+constexpr SinCosTable SIN_COS_TABLE;
+
+inline int normalizeDegrees(int degrees)
+{
+	degrees %= 360;
+	return degrees < 0 ? degrees + 360 : degrees;
+}
+
+  // Compute the corners of a halfWidth by halfHeight rectangle centered at
+  // (cx, cy) and rotated counterclockwise by angleDegrees, in the order
+  // lower left, lower right, upper right, upper left (before rotation).
+  // All four corners are rotated at once.
+
+inline void quadCorners(double cx, double cy, double halfWidth, double halfHeight,
+						int angleDegrees, float xs[4], float ys[4])
+{
+	int a = normalizeDegrees(angleDegrees);
+	double c = SIN_COS_TABLE.cosValue[a];
+	double s = SIN_COS_TABLE.sinValue[a];
+#ifdef SPRITEMATH_SSE2
+	float w = static_cast<float>(halfWidth);
+	float h = static_cast<float>(halfHeight);
+	__m128 px = _mm_set_ps(-w, w, w, -w);	// _mm_set_ps lists the lanes last to first
+	__m128 py = _mm_set_ps(h, h, -h, -h);
+	__m128 vc = _mm_set1_ps(static_cast<float>(c));
+	__m128 vs = _mm_set1_ps(static_cast<float>(s));
+	__m128 rx = _mm_sub_ps(_mm_mul_ps(px, vc), _mm_mul_ps(py, vs));
+	__m128 ry = _mm_add_ps(_mm_mul_ps(py, vc), _mm_mul_ps(px, vs));
+	_mm_storeu_ps(xs, _mm_add_ps(rx, _mm_set1_ps(static_cast<float>(cx))));
+	_mm_storeu_ps(ys, _mm_add_ps(ry, _mm_set1_ps(static_cast<float>(cy))));
+#else
+	const double px[4] = { -halfWidth, halfWidth, halfWidth, -halfWidth };
+	const double py[4] = { -halfHeight, -halfHeight, halfHeight, halfHeight };
+	for (int k = 0; k < 4; k++)
+	{
+		xs[k] = static_cast<float>(cx + px[k] * c - py[k] * s);
+		ys[k] = static_cast<float>(cy + py[k] * c + px[k] * s);
+	}
+#endif
+}
+
+#endif // SPRITEMATH_H_
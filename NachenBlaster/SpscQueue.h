@@ -0,0 +1,57 @@
+#ifndef SPSCQUEUE_H_
+#define SPSCQUEUE_H_
+
+#include <atomic>
+#include <cstddef>
+
+  // A fixed-size ring of values passed from one producer thread to one
+  // consumer thread without locks.  Capacity must be a power of two; one
+  // slot is always left empty to tell a full ring from an empty one.
+
+template<typename T, std::size_t Capacity>
+class SpscQueue
+{
+	static_assert((Capacity & (Capacity - 1)) == 0, "SpscQueue capacity must be a power of two");
+
+  public:
+	SpscQueue()
+	 : m_head(0), m_tail(0)
+	{
+	}
+
+	  // Producer side.  Returns false (dropping v) if the queue is full.
+	bool push(const T& v)
+	{
+		std::size_t tail = m_tail.load(std::memory_order_relaxed);
+		std::size_t next = (tail + 1) & MASK;
+		if (next == m_head.load(std::memory_order_acquire))
+			return false;
+		m_slots[tail] = v;
+		m_tail.store(next, std::memory_order_release);
+		return true;
+	}
+
+	  // Consumer side.  Returns false if the queue is empty.
+	bool pop(T& v)
+	{
+		std::size_t head = m_head.load(std::memory_order_relaxed);
+		if (head == m_tail.load(std::memory_order_acquire))
+			return false;
+		v = m_slots[head];
+		m_head.store((head + 1) & MASK, std::memory_order_release);
+		return true;
+	}
+
+  private:
+	static const std::size_t MASK = Capacity - 1;
+
+	T						 m_slots[Capacity];
+	std::atomic<std::size_t> m_head;	// next slot to pop; written only by the consumer
+	std::atomic<std::size_t> m_tail;	// next slot to push; written only by the producer
+
+	  // Prevent copying or assigning SpscQueues
+	SpscQueue(const SpscQueue&) = delete;
+	SpscQueue& operator=(const SpscQueue&) = delete;
+};
+
+#endif // SPSCQUEUE_H_
@@ -0,0 +1,109 @@
+#ifndef STROKEFONT_H_
+#define STROKEFONT_H_
+
+#include "freeglut.h"
+#include <string>
+
+  // GLUT's Roman stroke font, with each glyph compiled once into a display
+  // list instead of being sent to OpenGL vertex by vertex every time it's
+  // drawn.  Needs a current OpenGL context from init on.
+
+class StrokeFont
+{
+  public:
+	static const int NUM_GLYPHS = 128;
+
+	StrokeFont()
+	 : m_glyphBase(0)
+	{
+	}
+
+	~StrokeFont()
+	{
+		if (m_glyphBase != 0)
+			glDeleteLists(m_glyphBase, NUM_GLYPHS);
+	}
+
+	void init()
+	{
+		if (m_glyphBase != 0)
+			return;
+		m_glyphBase = glGenLists(NUM_GLYPHS);
+		for (int c = 0; c < NUM_GLYPHS; c++)
+		{
+			glNewList(m_glyphBase + c, GL_COMPILE);
+			glutStrokeCharacter(GLUT_STROKE_ROMAN, c);  // ends with a move to the next glyph
+			glEndList();
+		}
+	}
+
+	  // Call the glyph's list; characters outside the font draw nothing
+	void drawGlyph(unsigned char c) const
+	{
+		if (c < NUM_GLYPHS)
+			glCallList(m_glyphBase + c);
+	}
+
+  private:
+	GLuint m_glyphBase;
+
+	  // Prevent copying or assigning StrokeFonts
+	StrokeFont(const StrokeFont&) = delete;
+	StrokeFont& operator=(const StrokeFont&) = delete;
+};
+
+  // One line of stroke text, compiled into a single display list that is
+  // rebuilt only when the text changes.  Its length is cached along with it.
+
+class StrokeText
+{
+  public:
+	StrokeText()
+	 : m_list(0), m_length(0)
+	{
+	}
+
+	~StrokeText()
+	{
+		if (m_list != 0)
+			glDeleteLists(m_list, 1);
+	}
+
+	void setText(const StrokeFont& font, const std::string& text)
+	{
+		if (m_list != 0  &&  text == m_text)
+			return;
+		m_text = text;
+		const unsigned char* str = reinterpret_cast<const unsigned char*>(m_text.c_str());
+		m_length = glutStrokeLength(GLUT_STROKE_ROMAN, str);
+		if (m_list == 0)
+			m_list = glGenLists(1);
+		glNewList(m_list, GL_COMPILE);
+		for ( ; *str != '\0'; str++)
+			font.drawGlyph(*str);
+		glEndList();
+	}
+
+	  // Length in font units, as glutStrokeLength would say
+	double length() const
+	{
+		return m_length;
+	}
+
+	void draw() const
+	{
+		if (m_list != 0)
+			glCallList(m_list);
+	}
+
+  private:
+	GLuint		m_list;
+	std::string m_text;
+	double		m_length;
+
+	  // Prevent copying or assigning StrokeTexts
+	StrokeText(const StrokeText&) = delete;
+	StrokeText& operator=(const StrokeText&) = delete;
+};
+
+#endif // STROKEFONT_H_
@@ -2,51 +2,14 @@
 #include "GameConstants.h"
 #include "Actor.h"
 #include <string>
-#include <random>
 #include <iostream>
 #include <cmath>
 #include <math.h>
-#include <sstream>
-#include <iomanip>
 #include <algorithm>
+#include <cstring>
 using namespace std;
 
-string StudentWorld::updateText() const
-{
-    ostringstream oss;
-    oss.setf(ios::fixed);
-    oss.precision(0);
-    
-    double lives = getLives();
-    
-    double health = m_player->hitPoints();
-    double health_pct = health/0.5;
-    
-    double score = getScore();
-    
-    unsigned int level = getLevel();
-    
-    double cabbagePct = m_player->cabbagePct();
-    
-    int torpedos = m_player->numTorpedoes();
-    
-    oss << setw(10);
-    
-    oss << "Lives:"<< setw(2) << lives;
-    
-    oss << setw(9) << "Health:" <<setw(5) << health_pct <<"%";
-    
-    oss << setw(9) << "Score:" << setw(6) << score;
-    
-    oss << setw(7) << "Level:" << setw(3) << level;
-    
-    oss << setw(10) << "Cabbages:" << setw(5) << cabbagePct << "%";
-    
-    oss << setw(11) << "Torpedoes:" << setw(3) << torpedos;
-    
-    string s = oss.str();
-    return s;
-}
+static const uint32_t SNAPSHOT_MAGIC = 0x4e425331;  //"NBS1"
 
 GameWorld* createStudentWorld(string assetDir)
 {
@@ -56,7 +19,9 @@ GameWorld* createStudentWorld(string assetDir)
 //StudentWorld Implementation
 StudentWorld::StudentWorld(string assetDir):GameWorld(assetDir)
 {
-    
+    m_player = nullptr;
+    m_nextSerial = 0;
+    buildSpawnTable();
 }
 
 StudentWorld::~StudentWorld()
@@ -66,15 +31,21 @@ StudentWorld::~StudentWorld()
 
 int StudentWorld::init()
 {
+    //everything that depends only on the level is worked out here, so a
+    //caller that inits the next level ahead of time (see GameController)
+    //gets all of it done before play starts
+    buildSpawnTable();
+    warmUpActorPool();
     for (int i = 0; i < MAX_STARS; i++) {   //initialize stars
         double size = randDouble(MIN_STAR_SIZE, MAX_STAR_SIZE);
         int x = randInt(0, VIEW_WIDTH - 1);
         int y = randInt(0, VIEW_HEIGHT - 1);
-        m_actors.push_back(new Star(this, x, y, size));
+        spawnActor<Star>(x, y, size);
     }
-    m_player = new Player(this); //player restarts with full health and 0 torpedos each round
+    m_player = new (m_actorPool.allocate(sizeof(Player))) Player(this); //player restarts with full health and 0 torpedos each round
     m_alienShipsDestroyed = 0;
     m_alienShipsOnScreen = 0;
+    m_hud.invalidate();  //whoever shows the text may have changed since the last level
     return GWSTATUS_CONTINUE_GAME;
 }
 
@@ -86,63 +57,271 @@ int StudentWorld::move()
     else {
         return GWSTATUS_PLAYER_DIED;
     }
-    for (vector<Actor*>::iterator it = m_actors.begin(); it != m_actors.end();)
-    {
-        (*it)->doSomething();  //ask each alive actor to do something
-        if (m_player->isDead()) {  //check continuously to see if an action of another actor has caused the player to die
-            return GWSTATUS_PLAYER_DIED;
+    //each bucket acts in turn; actors only ever add actors of a later kind
+    //(or, like the player, before any bucket has acted), so everything added
+    //this tick still gets to act this tick.  Actors that die stay in their
+    //bucket, skipped, until the sweep at the end of the tick; if the tick
+    //ends early because the player died or the level is over, they're left
+    //for cleanUp.
+    for (int kind = 0; kind < NUM_ACTOR_KINDS; kind++) {
+        ActorBucket& bucket = m_buckets[kind];
+        size_t i = 0;
+        if (kind == KIND_STAR && !m_player->isDead() && m_alienShipsDestroyed != alienShipsNeededToBeDestroyed()) {
+            //stars can't kill the player or finish the level, so unless the
+            //player's move already did, they can all move in one tight loop
+            Star::moveAll(bucket);
+            i = bucket.size();
         }
-        if ((*it)->isDead()) {  //remove dead objects if they've flown off the screen or have lost all hitPoints
-            if ((*it)->isAlien()) {
-                m_alienShipsOnScreen--;
+        for (; i < bucket.size(); i++) {
+            if (!bucket.dead[i]) {
+                letActorAct(kind, bucket.actors[i]);  //ask each alive actor to do something
+            }
+            if (m_player->isDead()) {  //check continuously to see if an action of another actor has caused the player to die
+                return GWSTATUS_PLAYER_DIED;
+            }
+            if (m_alienShipsDestroyed == alienShipsNeededToBeDestroyed()) { //finished level
+                playSound(SOUND_FINISHED_LEVEL);
+                return GWSTATUS_FINISHED_LEVEL;
             }
-            delete (*it);
-            it = m_actors.erase(it);
-        }
-        else {
-            it++;
-        }
-        if (m_alienShipsDestroyed == alienShipsNeededToBeDestroyed()) { //finished level
-            playSound(SOUND_FINISHED_LEVEL);
-            return GWSTATUS_FINISHED_LEVEL;
         }
     }
+    removeDeadActors();
     //end of tick update actions
     introduceStars();
     introduceAliens();
-    setGameStatText(updateText());
+    if (m_hud.update(getLives(), llrint(m_player->hitPoints() / 0.5), getScore(), getLevel(),
+                     m_player->cabbagePct(), m_player->numTorpedoes())) {
+        setGameStatText(m_hud.text());
+    }
     return GWSTATUS_CONTINUE_GAME;
 }
 
 void StudentWorld::cleanUp()  //deletes all actors after current round is over
 {
-    delete m_player;
+    destroyActor(m_player);
     m_player = nullptr;
-    for (vector<Actor*>::iterator it = m_actors.begin(); it != m_actors.end();) {
-        delete (*it);
-        //(*it) = nullptr;
-        it = m_actors.erase(it);
+    m_alienGrid.clear();
+    m_buckets[KIND_PLAYER].truncate(0);
+    for (int kind = 0; kind < NUM_ACTOR_KINDS; kind++) {
+        for (size_t i = 0; i < m_buckets[kind].size(); i++) {
+            destroyActor(m_buckets[kind].actors[i]);
+        }
+        m_buckets[kind].truncate(0);
     }
 }
 
-Alien* StudentWorld::getOneCollidingAlien(const Actor* a) const
+uint64_t StudentWorld::stateHash() const
 {
-    double x1 = a->getX();
-    double y1 = a->getY();
-    double r1 = a->getRadius();
-    for (int i = 0; i < m_actors.size(); i++) {
-        if (m_actors[i]->isAlien()) {
-            double x2 = m_actors[i]->getX();
-            double y2 = m_actors[i]->getY();
-            double r2 = m_actors[i]->getRadius();
-            double distance = euclidianDistance(x1, x2, y1, y2);
-            double radiusFactor = 0.75 * (r1 + r2);
-            if (distance < radiusFactor) {
-                return dynamic_cast<Alien*>(m_actors[i]);
+    StateHasher h;
+    h.addInt(GameWorld::stateHash());
+    h.addInt(m_alienShipsDestroyed);
+    h.addInt(m_alienShipsOnScreen);
+    if (m_player != nullptr) {
+        h.addDouble(m_player->getX());
+        h.addDouble(m_player->getY());
+        h.addDouble(m_player->hitPoints());
+        h.addInt(m_player->cabbagePct());
+        h.addInt(m_player->numTorpedoes());
+    }
+    for (int kind = 0; kind < NUM_ACTOR_KINDS; kind++) {
+        h.addInt(m_buckets[kind].size());
+        for (size_t i = 0; i < m_buckets[kind].size(); i++) {
+            const Actor* a = m_buckets[kind].actors[i];
+            h.addInt(a->isDead());
+            h.addDouble(a->getX());
+            h.addDouble(a->getY());
+            h.addInt(a->getDirection());
+            h.addDouble(a->getSize());
+            h.addDouble(a->deltaY());
+            if (kind == KIND_ALIEN) {
+                h.addDouble(static_cast<const Alien*>(a)->hitPoints());
+            }
+        }
+    }
+    return h.value();
+}
+
+void StudentWorld::saveSnapshot(vector<unsigned char>& buffer) const
+{
+    SnapshotHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = SNAPSHOT_MAGIC;
+    size_t total = 0;
+    for (int kind = 0; kind < NUM_ACTOR_KINDS; kind++) {
+        header.numActors[kind] = m_buckets[kind].size();
+        total += m_buckets[kind].size();
+    }
+    saveState(header.world);
+    if (m_player != nullptr) {
+        header.hasPlayer = 1;
+        m_player->save(header.player);
+    }
+    header.alienShipsDestroyed = m_alienShipsDestroyed;
+    header.alienShipsOnScreen = m_alienShipsOnScreen;
+    header.nextSerial = m_nextSerial;
+
+    buffer.resize(sizeof(header) + total * sizeof(ActorRecord));
+    memcpy(buffer.data(), &header, sizeof(header));
+    unsigned char* out = buffer.data() + sizeof(header);
+    for (int kind = 0; kind < NUM_ACTOR_KINDS; kind++) {
+        for (size_t i = 0; i < m_buckets[kind].size(); i++) {
+            ActorRecord r;
+            memset(&r, 0, sizeof(r));
+            m_buckets[kind].actors[i]->save(r);
+            memcpy(out, &r, sizeof(r));
+            out += sizeof(r);
+        }
+    }
+}
+
+bool StudentWorld::restoreSnapshot(const unsigned char* data, size_t size)
+{
+    SnapshotHeader header;
+    if (size < sizeof(header)) {
+        return false;
+    }
+    memcpy(&header, data, sizeof(header));
+    size_t total = 0;
+    for (int kind = 0; kind < NUM_ACTOR_KINDS; kind++) {
+        total += header.numActors[kind];
+    }
+    if (header.magic != SNAPSHOT_MAGIC || size != sizeof(header) + total * sizeof(ActorRecord)) {
+        return false;
+    }
+
+    cleanUp();
+    restoreState(header.world);
+    buildSpawnTable();
+    if (header.hasPlayer) {
+        m_player = new (m_actorPool.allocate(sizeof(Player))) Player(this);
+        m_player->moveTo(header.player.x, header.player.y);
+        m_player->restore(header.player);
+    }
+    //rebuilding the actors in bucket order hands out serials in the same
+    //order as before, which is all the grid's tie-breaking cares about
+    m_nextSerial = 0;
+    const unsigned char* in = data + sizeof(header);
+    for (int kind = 0; kind < NUM_ACTOR_KINDS; kind++) {
+        for (uint32_t i = 0; i < header.numActors[kind]; i++) {
+            ActorRecord r;
+            memcpy(&r, in, sizeof(r));
+            in += sizeof(r);
+            Actor* a = rebuildActor(r);
+            if (a != nullptr) {
+                a->restore(r);
+            }
+        }
+    }
+    m_alienShipsDestroyed = header.alienShipsDestroyed;
+    m_alienShipsOnScreen = header.alienShipsOnScreen;
+    m_nextSerial = header.nextSerial;
+    return true;
+}
+
+void StudentWorld::writeObservation(float* out) const
+{
+    fill(out, out + OBS_SIZE, 0.0f);
+    if (m_player != nullptr) {
+        out[0] = m_player->getX() / VIEW_WIDTH;
+        out[1] = m_player->getY() / VIEW_HEIGHT;
+        out[2] = m_player->healthPct() / 100.0f;
+        out[3] = m_player->cabbagePct() / 100.0f;
+        out[4] = m_player->numTorpedoes();
+        out[5] = getLives();
+        out[6] = getLevel();
+        out[7] = 1.0f;
+    }
+    float* slot = out + OBS_PLAYER_FIELDS;
+    int slotsLeft = OBS_MAX_OBJECTS;
+    for (int kind = KIND_ALIEN; kind <= KIND_GOODIE && slotsLeft > 0; kind++) {
+        for (size_t i = 0; i < m_buckets[kind].size() && slotsLeft > 0; i++) {
+            const Actor* a = m_buckets[kind].actors[i];
+            if (a->isDead()) {
+                continue;
+            }
+            slot[0] = 1.0f;
+            slot[1] = kind;
+            slot[2] = a->getImageID();
+            slot[3] = a->getX() / VIEW_WIDTH;
+            slot[4] = a->getY() / VIEW_HEIGHT;
+            slot[5] = a->deltaX();
+            slot[6] = a->deltaY();
+            if (kind == KIND_ALIEN) {
+                slot[7] = static_cast<const Alien*>(a)->hitPoints();
+            }
+            slot += OBS_OBJECT_FIELDS;
+            slotsLeft--;
+        }
+    }
+}
+
+//create an actor of the class that saved r, at r's position
+Actor* StudentWorld::rebuildActor(const ActorRecord& r)
+{
+    switch (r.imageID) {
+        case IID_STAR:
+            return spawnActor<Star>(r.x, r.y, r.size);
+        case IID_EXPLOSION:
+            return spawnActor<Explosion>(r.x, r.y);
+        case IID_SMALLGON:
+            return spawnActor<Smallgon>(r.x, r.y);
+        case IID_SMOREGON:
+            return spawnActor<Smoregon>(r.x, r.y);
+        case IID_SNAGGLEGON:
+            return spawnActor<Snagglegon>(r.x, r.y);
+        case IID_CABBAGE:
+            return spawnActor<Cabbage>(r.x, r.y);
+        case IID_TURNIP:
+            return spawnActor<Turnip>(r.x, r.y);
+        case IID_TORPEDO:
+            if (r.deltaX > 0) {
+                return spawnActor<PlayerLaunchedTorpedo>(r.x, r.y);
+            }
+            return spawnActor<AlienLaunchedTorpedo>(r.x, r.y);
+        case IID_LIFE_GOODIE:
+            return spawnActor<ExtraLifeGoodie>(r.x, r.y);
+        case IID_REPAIR_GOODIE:
+            return spawnActor<RepairGoodie>(r.x, r.y);
+        case IID_TORPEDO_GOODIE:
+            return spawnActor<TorpedoGoodie>(r.x, r.y);
+        default:
+            return nullptr;
+    }
+}
+
+//remove objects that have flown off the screen or have lost all hitPoints,
+//in one pass per bucket that keeps the survivors in order
+void StudentWorld::removeDeadActors()
+{
+    for (int kind = 0; kind < NUM_ACTOR_KINDS; kind++) {
+        ActorBucket& bucket = m_buckets[kind];
+        size_t kept = 0;
+        for (size_t i = 0; i < bucket.size(); i++) {
+            if (bucket.dead[i]) {
+                Actor* a = bucket.actors[i];
+                if (kind == KIND_ALIEN) {
+                    m_alienShipsOnScreen--;
+                    m_alienGrid.remove(a);
+                }
+                destroyActor(a);
+            }
+            else {
+                if (kept != i) {
+                    bucket.moveSlot(i, kept);
+                }
+                kept++;
             }
         }
+        bucket.truncate(kept);
     }
-    return nullptr;
+}
+
+Alien* StudentWorld::getOneCollidingAlien(const Actor* a) const
+{
+    //only aliens are in the grid, and the earliest-added one wins, just as
+    //if we had scanned the alien bucket from the front
+    Actor* alien = m_alienGrid.findOverlapping(a->getX(), a->getY(), a->getRadius(), 0.75);
+    return static_cast<Alien*>(alien);
 }
 
 Player* StudentWorld::getCollidingPlayer(const Actor* a) const
@@ -168,19 +347,44 @@ bool StudentWorld::playerInLineOfFire(const Alien* a) const
     return a->getX() > m_player->getX() && a->getY() >= m_player->getY() - 4 && a->getY() <= m_player->getY() + 4;
 }
 
+//the actor already has its slot in its bucket, taken when it was built
 void StudentWorld::addActor(Actor* a)
 {
-    m_actors.push_back(a);
     if (a->isAlien()) {
         m_alienShipsOnScreen++;
+        m_alienGrid.insert(a, m_nextSerial);
+    }
+    m_nextSerial++;
+}
+
+void StudentWorld::destroyActor(Actor* a)
+{
+    if (a != nullptr) {
+        a->~Actor();
+        m_actorPool.release(a);
     }
 }
 
+unsigned long StudentWorld::actorPoolAllocations() const
+{
+    return m_actorPool.globalAllocations();
+}
+
+void StudentWorld::actorMoved(Actor* a)
+{
+    m_alienGrid.update(a);
+}
+
 void StudentWorld::recordAlienDestroyed()
 {
     m_alienShipsDestroyed++;
 }
 
+ActorBucket& StudentWorld::actorsOfKind(int kind)
+{
+    return m_buckets[kind];
+}
+
 //private algorithms
 int StudentWorld::alienShipsNeededToBeDestroyed() const
 {
@@ -192,14 +396,14 @@ int StudentWorld::maxAlienShipsOnScreen() const
     return 4 + 0.5 * getLevel();
 }
 
-double StudentWorld::randDouble(double min, double max) const
+int StudentWorld::randInt(int min, int max)
+{
+    return random(RNG_SPAWN).randInt(min, max);
+}
+
+double StudentWorld::randDouble(double min, double max)
 {
-    if (max < min)
-        std::swap(max, min);
-    static std::random_device rd;
-    static std::mt19937 generator(rd());
-    std::uniform_real_distribution<> dis(min, max); //modification for double and float values
-    return dis(generator);
+    return random(RNG_SPAWN).randDouble(min, max);
 }
 
 double StudentWorld::euclidianDistance(double x1, double x2, double y1, double y2) const
@@ -230,67 +434,104 @@ void StudentWorld::introduceStars()
         double size = randDouble(MIN_STAR_SIZE, MAX_STAR_SIZE);
         int x = VIEW_WIDTH - 1;
         int y = randInt(0, VIEW_HEIGHT - 1);
-        m_actors.push_back(new Star(this, x, y, size));
+        spawnActor<Star>(x, y, size);
     }
 }
 
 void StudentWorld::introduceAliens()
 {
     if (shouldAddAlien()) {
-        vector<int> chances;
-        int s1 = 60;
-        int s2 = 20 + 5 * getLevel();
-        int s3 = 5 + 10 * getLevel();
-        chances.push_back(s1);
-        chances.push_back(s2);
-        chances.push_back(s3);
-        sort(chances.begin(), chances.end());
-        int s = s1 + s2 + s3;
         int y = randInt(0, VIEW_HEIGHT - 1);
-        int r = randInt(1, s);
-        if (r <= chances[0]) {
-            if (chances[0] == s1) {
-                addActor(new Smallgon(this, VIEW_WIDTH - 1, y));
-            }
-            else if (chances[0] == s2){
-                addActor(new Smoregon(this, VIEW_WIDTH - 1, y));
-            }
-            else {
-                addActor(new Snagglegon(this, VIEW_WIDTH - 1, y));
-            }
-        }
-        else if (r > chances[0] && r <= (chances[0] + chances[1])){
-            if (chances[1] == s1) {
-                addActor(new Smallgon(this, VIEW_WIDTH - 1, y));
-            }
-            else if (chances[1] == s2){
-                addActor(new Smoregon(this, VIEW_WIDTH - 1, y));
-            }
-            else {
-                addActor(new Snagglegon(this, VIEW_WIDTH - 1, y));
-            }
+        int r = randInt(1, m_spawnTable.total);
+        int i = 0;
+        for (int upTo = m_spawnTable.chances[0]; i < 2 && r > upTo; upTo += m_spawnTable.chances[i]) {
+            i++;
         }
-        else{
-            if (chances[2] == s1) {
-                addActor(new Smallgon(this, VIEW_WIDTH - 1, y));
-            }
-            else if (chances[2] == s2){
-                addActor(new Smoregon(this, VIEW_WIDTH - 1, y));
-            }
-            else {
-                addActor(new Snagglegon(this, VIEW_WIDTH - 1, y));
-            }
+        switch (m_spawnTable.kinds[i]) {
+            case IID_SMALLGON:
+                spawnActor<Smallgon>(VIEW_WIDTH - 1, y);
+                break;
+            case IID_SMOREGON:
+                spawnActor<Smoregon>(VIEW_WIDTH - 1, y);
+                break;
+            default:
+                spawnActor<Snagglegon>(VIEW_WIDTH - 1, y);
+                break;
         }
     }
 }
 
+//the odds of each kind of alien, smallest first, for the current level
+//(when two are equal, the first of Smallgon, Smoregon, Snagglegon wins both)
+void StudentWorld::buildSpawnTable()
+{
+    int s1 = 60;
+    int s2 = 20 + 5 * getLevel();
+    int s3 = 5 + 10 * getLevel();
+    int chances[3] = { s1, s2, s3 };
+    sort(chances, chances + 3);
+    for (int i = 0; i < 3; i++) {
+        m_spawnTable.chances[i] = chances[i];
+        if (chances[i] == s1) {
+            m_spawnTable.kinds[i] = IID_SMALLGON;
+        }
+        else if (chances[i] == s2) {
+            m_spawnTable.kinds[i] = IID_SMOREGON;
+        }
+        else {
+            m_spawnTable.kinds[i] = IID_SNAGGLEGON;
+        }
+    }
+    m_spawnTable.total = s1 + s2 + s3;
+}
 
+//get the actor pool holding as many free blocks as a level like this one
+//has actors alive at once, so play itself never has to wait on the global
+//allocator (kinds of actor that share a block size share the reservation)
+void StudentWorld::warmUpActorPool()
+{
+    int aliens = maxAlienShipsOnScreen();
+    m_actorPool.reserve(sizeof(Star), 2 * MAX_STARS);
+    m_actorPool.reserve(sizeof(Player), 1);
+    m_actorPool.reserve(sizeof(Smallgon), aliens);
+    m_actorPool.reserve(sizeof(Smoregon), aliens);
+    m_actorPool.reserve(sizeof(Snagglegon), aliens);
+    m_actorPool.reserve(sizeof(Explosion), aliens);
+    m_actorPool.reserve(sizeof(Cabbage), 16);
+    m_actorPool.reserve(sizeof(Turnip), 2 * aliens);
+    m_actorPool.reserve(sizeof(PlayerLaunchedTorpedo), 4);
+    m_actorPool.reserve(sizeof(AlienLaunchedTorpedo), aliens);
+    m_actorPool.reserve(sizeof(ExtraLifeGoodie), 2);
+    m_actorPool.reserve(sizeof(RepairGoodie), 2);
+    m_actorPool.reserve(sizeof(TorpedoGoodie), 2);
+    //and the buckets room for them, so their arrays don't grow in play either
+    m_buckets[KIND_STAR].reserve(2 * MAX_STARS);
+    m_buckets[KIND_ALIEN].reserve(aliens);
+    m_buckets[KIND_PROJECTILE].reserve(16 + 3 * aliens + 4);
+    m_buckets[KIND_GOODIE].reserve(6);
+    m_buckets[KIND_EXPLOSION].reserve(aliens);
+    m_buckets[KIND_PLAYER].reserve(1);
+}
 
-
-
-
-
-
-
-
-
+//every kind of actor has exactly one doSomething, so call it directly
+//rather than through the virtual table
+void StudentWorld::letActorAct(int kind, Actor* a)
+{
+    switch (kind) {
+        case KIND_STAR:
+            static_cast<Star*>(a)->Star::doSomething();
+            break;
+        case KIND_ALIEN:
+            static_cast<Alien*>(a)->Alien::doSomething();
+            break;
+        case KIND_PROJECTILE:
+            static_cast<Projectile*>(a)->Projectile::doSomething();
+            break;
+        case KIND_GOODIE:
+            static_cast<Goodie*>(a)->Goodie::doSomething();
+            break;
+        default:
+            static_cast<Explosion*>(a)->Explosion::doSomething();
+            break;
+    }
+}
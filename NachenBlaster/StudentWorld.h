@@ -2,27 +2,55 @@
 #define STUDENTWORLD_H_
 
 #include "GameWorld.h"
+#include "SpatialGrid.h"
+#include "Actor.h"
+#include "ActorPool.h"
+#include "HudText.h"
 #include <string>
 #include <vector>
 #include <iostream>
-
-class Actor;
-class Alien;
-class Player;
+#include <new>
+#include <cstdint>
+#include <cstddef>
 
 const int MAX_STARS = 30;
 const double MIN_STAR_SIZE = 0.05;
 const double MAX_STAR_SIZE = 0.5;
 
+// What a learning agent sees of the world: OBS_PLAYER_FIELDS numbers about
+// the player (x, y, health, cabbage energy, torpedoes, lives, level, and
+// whether there is a player at all), then OBS_MAX_OBJECTS slots of
+// OBS_OBJECT_FIELDS numbers (present, kind, image ID, x, y, deltaX, deltaY,
+// hit points) for the aliens, projectiles and goodies in the world, in
+// bucket order.  Positions are scaled to [0, 1); unused slots are all zero.
+const int OBS_PLAYER_FIELDS = 8;
+const int OBS_MAX_OBJECTS = 32;
+const int OBS_OBJECT_FIELDS = 8;
+const int OBS_SIZE = OBS_PLAYER_FIELDS + OBS_MAX_OBJECTS * OBS_OBJECT_FIELDS;
+
+// The start of a snapshot buffer.  After it come numActors[kind]
+// ActorRecords for each bucket in turn, in bucket order.
+struct SnapshotHeader
+{
+    std::uint32_t magic;
+    std::uint32_t numActors[NUM_ACTOR_KINDS];
+    GameWorldState world;
+    std::uint32_t hasPlayer;
+    ActorRecord player;
+    int alienShipsDestroyed;
+    int alienShipsOnScreen;
+    std::uint64_t nextSerial;
+};
+
 class StudentWorld : public GameWorld
 {
 public:
     StudentWorld(std::string assetDir);
     virtual ~StudentWorld();
-    std::string updateText() const;
     virtual int init();
     virtual int move();
     virtual void cleanUp();
+    virtual std::uint64_t stateHash() const;
     // If there's at least one alien that's collided with a, return
     // a pointer to one of them; otherwise, return a null pointer.
     Alien* getOneCollidingAlien(const Actor* a) const;
@@ -31,22 +59,66 @@ public:
     Player* getCollidingPlayer(const Actor* a) const;
     // Is the player in the line of fire of a, which might cause a to attack?
     bool playerInLineOfFire(const Alien* a) const;
-    // Add an actor to the world.
-    void addActor(Actor* a);
+    // Create an actor of type T out of the world's actor pool and add it
+    // to the world.  The arguments are those of T's constructor after the
+    // world itself.
+    template<typename T, typename... Args>
+    T* spawnActor(Args... args)
+    {
+        T* a = new (m_actorPool.allocate(sizeof(T))) T(this, args...);
+        addActor(a);
+        return a;
+    }
+    // How many times has the actor pool had to call the global allocator?
+    unsigned long actorPoolAllocations() const;
+    // Save the whole state of the game into buffer as plain data with no
+    // pointers, which can be copied, kept or restored into any StudentWorld.
+    // buffer is reused, so saving into the same one again doesn't allocate.
+    void saveSnapshot(std::vector<unsigned char>& buffer) const;
+    // Put the game back exactly as it was when the snapshot in data was
+    // saved.  Returns false, changing nothing, if data isn't a snapshot.
+    bool restoreSnapshot(const unsigned char* data, std::size_t size);
+    // Write OBS_SIZE numbers describing the world into out.
+    void writeObservation(float* out) const;
+    // Tell the world that a has moved.
+    void actorMoved(Actor* a);
     // Record that one more alien on the current level has been destroyed.
     void recordAlienDestroyed();
+    // The bucket that actors of the given kind (or KIND_PLAYER) keep their
+    // fields in.
+    ActorBucket& actorsOfKind(int kind);
 private:
-    std::vector<Actor*> m_actors;
+    ActorPool m_actorPool;  //must outlive every actor, so declared first
+    ActorBucket m_buckets[NUM_ACTOR_KINDS + 1];  //one bucket per kind of actor, in the order they were added, then the player's
+    SpatialGrid m_alienGrid;  //every alien in m_buckets, for collision queries
+    unsigned long m_nextSerial;  //order in which actors were added
     Player* m_player;
     int m_alienShipsDestroyed;
     int m_alienShipsOnScreen;  //help determine if any new aliens need to be added
+    HudText m_hud;  //the status line, reformatted only when it changes
+    //which alien to add for a random number from 1 to total: kinds[0] up
+    //to chances[0], kinds[1] up to chances[0] + chances[1], else kinds[2]
+    struct SpawnTable {
+        int chances[3];
+        int kinds[3];  //IID_SMALLGON, IID_SMOREGON or IID_SNAGGLEGON
+        int total;
+    };
+    SpawnTable m_spawnTable;  //for the current level
     int alienShipsNeededToBeDestroyed() const;
     int maxAlienShipsOnScreen() const;
-    double randDouble(double min, double max) const;  //random double generator
+    int randInt(int min, int max);  //random numbers for spawning things
+    double randDouble(double min, double max);
     double euclidianDistance(double x1, double x2, double y1, double y2) const;
     bool shouldAddAlien() const;
     void introduceStars();
     void introduceAliens();
+    void buildSpawnTable();
+    void warmUpActorPool();
+    void letActorAct(int kind, Actor* a);
+    void addActor(Actor* a);
+    Actor* rebuildActor(const ActorRecord& r);
+    void destroyActor(Actor* a);
+    void removeDeadActors();
 };
 
 #endif // STUDENTWORLD_H_
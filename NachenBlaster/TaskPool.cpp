@@ -0,0 +1,71 @@
+#include "TaskPool.h"
+using namespace std;
+
+TaskPool::TaskPool(int numThreads)
+ : m_unfinished(0), m_stopping(false)
+{
+	if (numThreads < 1)
+		numThreads = static_cast<int>(thread::hardware_concurrency());
+	if (numThreads < 1)
+		numThreads = 1;
+	for (int k = 0; k < numThreads; k++)
+		m_workers.push_back(thread(&TaskPool::workerLoop, this));
+}
+
+TaskPool::~TaskPool()
+{
+	{
+		lock_guard<mutex> lock(m_mutex);
+		m_stopping = true;
+	}
+	m_workReady.notify_all();
+	for (thread& t : m_workers)
+		t.join();
+}
+
+void TaskPool::submit(function<void()> task)
+{
+	{
+		lock_guard<mutex> lock(m_mutex);
+		m_tasks.push_back(move(task));
+		m_unfinished++;
+	}
+	m_workReady.notify_one();
+}
+
+void TaskPool::wait()
+{
+	unique_lock<mutex> lock(m_mutex);
+	m_workDone.wait(lock, [this] { return m_unfinished == 0; });
+}
+
+void TaskPool::parallelFor(int count, const function<void(int)>& task)
+{
+	for (int k = 0; k < count; k++)
+		submit([&task, k] { task(k); });
+	wait();
+}
+
+  // Tasks still queued when the pool is destroyed are run first
+
+void TaskPool::workerLoop()
+{
+	for (;;)
+	{
+		function<void()> task;
+		{
+			unique_lock<mutex> lock(m_mutex);
+			m_workReady.wait(lock, [this] { return m_stopping  ||  !m_tasks.empty(); });
+			if (m_tasks.empty())
+				return;
+			task = move(m_tasks.front());
+			m_tasks.pop_front();
+		}
+		task();
+		{
+			lock_guard<mutex> lock(m_mutex);
+			if (--m_unfinished == 0)
+				m_workDone.notify_all();
+		}
+	}
+}
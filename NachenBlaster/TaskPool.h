@@ -0,0 +1,52 @@
+#ifndef TASKPOOL_H_
+#define TASKPOOL_H_
+
+#include <vector>
+#include <deque>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+  // A fixed set of worker threads running tasks in the order they were
+  // submitted.  Meant for coarse jobs like decoding a file, not for the
+  // tick loop: submitting allocates.
+
+class TaskPool
+{
+  public:
+	  // numThreads < 1 means one per hardware thread.
+	explicit TaskPool(int numThreads = 0);
+	~TaskPool();
+
+	int numThreads() const
+	{
+		return static_cast<int>(m_workers.size());
+	}
+
+	void submit(std::function<void()> task);
+
+	  // Wait until every task submitted so far has finished.
+	void wait();
+
+	  // Run task(0) through task(count-1) on the workers and wait for them
+	  // (and anything else submitted).  Not to be called from a task.
+	void parallelFor(int count, const std::function<void(int)>& task);
+
+  private:
+	std::vector<std::thread>		  m_workers;
+	std::deque<std::function<void()>> m_tasks;
+	std::mutex						  m_mutex;
+	std::condition_variable			  m_workReady;
+	std::condition_variable			  m_workDone;
+	int								  m_unfinished;	// queued or running
+	bool							  m_stopping;
+
+	void workerLoop();
+
+	  // Prevent copying or assigning TaskPools
+	TaskPool(const TaskPool&) = delete;
+	TaskPool& operator=(const TaskPool&) = delete;
+};
+
+#endif // TASKPOOL_H_
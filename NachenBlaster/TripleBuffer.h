@@ -0,0 +1,68 @@
+#ifndef TRIPLEBUFFER_H_
+#define TRIPLEBUFFER_H_
+
+#include <atomic>
+
+  // Hands values from one writer thread to one reader thread without locks
+  // and without either ever waiting for the other.  Of the three slots, the
+  // writer fills the back one and the reader reads the front one; publish
+  // and acquireLatest swap those with the middle one.  The reader always
+  // gets the most recently published value, and values published while it
+  // wasn't looking are simply dropped.
+  //
+  // The writer must overwrite everything in back() before each publish: it
+  // is handed whichever slot the reader last gave up, not its own previous
+  // one.
+
+template<typename T>
+class TripleBuffer
+{
+  public:
+	TripleBuffer()
+	 : m_front(0), m_middle(1), m_back(2)
+	{
+	}
+
+	  // Writer side
+
+	T& back()
+	{
+		return m_slots[m_back];
+	}
+
+	void publish()
+	{
+		m_back = m_middle.exchange(m_back | FRESH, std::memory_order_acq_rel) & INDEX_MASK;
+	}
+
+	  // Reader side.  Return true if something was published since the last
+	  // call, after which front() is the newest value.
+
+	bool acquireLatest()
+	{
+		if ((m_middle.load(std::memory_order_relaxed) & FRESH) == 0)
+			return false;
+		m_front = m_middle.exchange(m_front, std::memory_order_acq_rel) & INDEX_MASK;
+		return true;
+	}
+
+	const T& front() const
+	{
+		return m_slots[m_front];
+	}
+
+  private:
+	static const int INDEX_MASK = 3;
+	static const int FRESH		= 4;	// set in m_middle when the writer has published into it
+
+	T				 m_slots[3];
+	int				 m_front;	// touched only by the reader
+	std::atomic<int> m_middle;
+	int				 m_back;	// touched only by the writer
+
+	  // Prevent copying or assigning TripleBuffers
+	TripleBuffer(const TripleBuffer&) = delete;
+	TripleBuffer& operator=(const TripleBuffer&) = delete;
+};
+
+#endif // TRIPLEBUFFER_H_
@@ -0,0 +1,204 @@
+#include "VecEnv.h"
+#include "GameHost.h"
+#include "GameConstants.h"
+#include <string>
+using namespace std;
+
+int actionKey(int action)
+{
+	static const int keys[NUM_ACTIONS] = {
+		0, KEY_PRESS_LEFT, KEY_PRESS_RIGHT, KEY_PRESS_UP, KEY_PRESS_DOWN,
+		KEY_PRESS_SPACE, KEY_PRESS_TAB
+	};
+	if (action < 0  ||  action >= NUM_ACTIONS)
+		return 0;
+	return keys[action];
+}
+
+  // One world, and the host it talks to: the key for the current tick comes
+  // from the action, and sounds and the status line go nowhere.
+
+class VecEnv::Env : public GameHost
+{
+  public:
+	Env(uint64_t seed)
+	 : m_world(""), m_key(0)
+	{
+		m_world.seedRandom(seed);
+		m_world.setController(this);
+	}
+
+	void reset(float* observation)
+	{
+		m_world.cleanUp();
+		m_world.startNewGame();
+		m_world.init();
+		if (observation != nullptr)
+			m_world.writeObservation(observation);
+	}
+
+	void step(int action, float& reward, unsigned char& done, float* observation)
+	{
+		m_key = actionKey(action);
+		unsigned int scoreBefore = m_world.getScore();
+		int status = m_world.tick();
+		m_key = 0;
+		reward = static_cast<float>(m_world.getScore() - scoreBefore);
+		done = 0;
+		if (status == GWSTATUS_PLAYER_DIED)
+		{
+			done = 1;
+			if (m_world.isGameOver())
+				m_world.startNewGame();
+			m_world.cleanUp();
+			m_world.init();
+		}
+		else if (status == GWSTATUS_FINISHED_LEVEL)
+		{
+			done = 1;
+			m_world.advanceToNextLevel();
+			m_world.cleanUp();
+			m_world.init();
+		}
+		if (observation != nullptr)
+			m_world.writeObservation(observation);
+	}
+
+	virtual bool getLastKey(int& value)
+	{
+		if (m_key == 0)
+			return false;
+		value = m_key;
+		m_key = 0;
+		return true;
+	}
+
+	virtual void playSound(int)
+	{
+	}
+
+	virtual void playSounds(const SoundBatch&)
+	{
+	}
+
+	virtual void setGameStatText(const char*)
+	{
+	}
+
+	virtual void quitGame()
+	{
+	}
+
+  private:
+	StudentWorld m_world;
+	int			 m_key;
+};
+
+VecEnv::VecEnv(int numEnvs, int numThreads, uint64_t seed)
+ : m_generation(0), m_busyWorkers(0), m_stopping(false), m_resetting(false),
+   m_actions(nullptr), m_rewards(nullptr), m_dones(nullptr),
+   m_observations(nullptr)
+{
+	if (numEnvs < 0)
+		numEnvs = 0;
+	for (int k = 0; k < numEnvs; k++)
+		m_envs.push_back(new Env(seed + k));
+
+	m_numShards = numThreads;
+	if (m_numShards > numEnvs)
+		m_numShards = numEnvs;
+	if (m_numShards < 1)
+		m_numShards = 1;
+	for (int shard = 1; shard < m_numShards; shard++)
+		m_workers.push_back(thread(&VecEnv::workerLoop, this, shard));
+
+	reset(nullptr);
+}
+
+VecEnv::~VecEnv()
+{
+	{
+		lock_guard<mutex> lock(m_mutex);
+		m_stopping = true;
+	}
+	m_workReady.notify_all();
+	for (thread& t : m_workers)
+		t.join();
+	for (Env* e : m_envs)
+		delete e;
+}
+
+void VecEnv::reset(float* observations)
+{
+	m_resetting = true;
+	m_observations = observations;
+	runAll();
+}
+
+void VecEnv::step(const int* actions, float* rewards, unsigned char* dones, float* observations)
+{
+	m_resetting = false;
+	m_actions = actions;
+	m_rewards = rewards;
+	m_dones = dones;
+	m_observations = observations;
+	runAll();
+}
+
+  // Hand the batch to the workers, do shard 0 on this thread, and wait for
+  // the rest.
+
+void VecEnv::runAll()
+{
+	if (!m_workers.empty())
+	{
+		{
+			lock_guard<mutex> lock(m_mutex);
+			m_generation++;
+			m_busyWorkers = static_cast<int>(m_workers.size());
+		}
+		m_workReady.notify_all();
+	}
+	runShard(0);
+	if (!m_workers.empty())
+	{
+		unique_lock<mutex> lock(m_mutex);
+		m_workDone.wait(lock, [this] { return m_busyWorkers == 0; });
+	}
+}
+
+void VecEnv::runShard(int shard)
+{
+	int n = numEnvs();
+	int begin = static_cast<int>(static_cast<long long>(n) * shard / m_numShards);
+	int end = static_cast<int>(static_cast<long long>(n) * (shard + 1) / m_numShards);
+	for (int k = begin; k < end; k++)
+	{
+		float* observation = m_observations == nullptr ? nullptr : m_observations + static_cast<size_t>(k) * OBS_SIZE;
+		if (m_resetting)
+			m_envs[k]->reset(observation);
+		else
+			m_envs[k]->step(m_actions[k], m_rewards[k], m_dones[k], observation);
+	}
+}
+
+void VecEnv::workerLoop(int shard)
+{
+	unsigned long done = 0;
+	for (;;)
+	{
+		{
+			unique_lock<mutex> lock(m_mutex);
+			m_workReady.wait(lock, [&] { return m_stopping  ||  m_generation != done; });
+			if (m_stopping)
+				return;
+			done = m_generation;
+		}
+		runShard(shard);
+		{
+			lock_guard<mutex> lock(m_mutex);
+			if (--m_busyWorkers == 0)
+				m_workDone.notify_one();
+		}
+	}
+}
@@ -0,0 +1,88 @@
+#ifndef VECENV_H_
+#define VECENV_H_
+
+#include "StudentWorld.h"
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+
+  // What an agent can do on one tick.  Each action is the key a player
+  // would have pressed (see actionKey).
+
+const int ACTION_NONE		  = 0;
+const int ACTION_LEFT		  = 1;
+const int ACTION_RIGHT		  = 2;
+const int ACTION_UP			  = 3;
+const int ACTION_DOWN		  = 4;
+const int ACTION_FIRE_CABBAGE = 5;
+const int ACTION_FIRE_TORPEDO = 6;
+const int NUM_ACTIONS		  = 7;
+
+  // Return the KEY_PRESS_* constant for an action, or 0 for ACTION_NONE or
+  // anything out of range.
+int actionKey(int action);
+
+  // Runs numEnvs independent StudentWorlds side by side, for driving the
+  // game as a reinforcement learning environment.  Every step advances all
+  // of them one tick, with the worlds split into numThreads shards that run
+  // in parallel.  All results go into caller-provided arrays indexed by
+  // world: rewards and dones have numEnvs entries, observations numEnvs
+  // blocks of OBS_SIZE floats (see StudentWorld::writeObservation).
+  //
+  // A world is done when its player dies or finishes the level; it then
+  // carries on as GameController would (cleanUp and init for the next life
+  // or level, or a whole new game if that was the last life), and the
+  // observation written is the first one of what comes next.
+
+class VecEnv
+{
+  public:
+	  // World k is seeded with seed+k, so the same seed and actions always
+	  // give the same results.
+	VecEnv(int numEnvs, int numThreads, std::uint64_t seed);
+	~VecEnv();
+
+	int numEnvs() const
+	{
+		return static_cast<int>(m_envs.size());
+	}
+
+	  // Start every world on a new game.  observations may be null.
+	void reset(float* observations);
+
+	  // Advance every world one tick, world k doing actions[k].  rewards[k]
+	  // gets the points world k scored this tick; observations may be null.
+	void step(const int* actions, float* rewards, unsigned char* dones, float* observations);
+
+  private:
+	class Env;
+
+	std::vector<Env*>		 m_envs;
+	std::vector<std::thread> m_workers;		// shard k+1 runs on m_workers[k]
+	int						 m_numShards;
+	std::mutex				 m_mutex;
+	std::condition_variable	 m_workReady;
+	std::condition_variable	 m_workDone;
+	unsigned long			 m_generation;	// counts batches of work handed out
+	int						 m_busyWorkers;
+	bool					 m_stopping;
+
+	  // The batch of work in progress
+	bool			 m_resetting;
+	const int*		 m_actions;
+	float*			 m_rewards;
+	unsigned char*	 m_dones;
+	float*			 m_observations;
+
+	void runAll();
+	void runShard(int shard);
+	void workerLoop(int shard);
+
+	  // Prevent copying or assigning VecEnvs
+	VecEnv(const VecEnv&) = delete;
+	VecEnv& operator=(const VecEnv&) = delete;
+};
+
+#endif // VECENV_H_
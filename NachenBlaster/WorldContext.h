@@ -0,0 +1,85 @@
+#ifndef WORLDCONTEXT_H_
+#define WORLDCONTEXT_H_
+
+#include "GraphObject.h"
+#include "RandomGenerator.h"
+#include <cstdint>
+
+class GameHost;
+class ReplayRecorder;
+
+  // Everything a running game needs that isn't the game itself: the objects
+  // it draws, its random number streams, the host that supplies its keys
+  // and plays its sounds, and where its input is being recorded.  Each
+  // GameWorld owns its own context and nothing here is shared, so any
+  // number of worlds can run on different threads without locks.
+
+class WorldContext
+{
+  public:
+	WorldContext()
+	 : m_host(nullptr), m_recorder(nullptr)
+	{
+		seedRandom(0);
+	}
+
+	GraphObjectRegistry& graphObjects()
+	{
+		return m_graphObjects;
+	}
+
+	void seedRandom(std::uint64_t seed)
+	{
+		m_seed = seed;
+		for (int k = 0; k < NUM_RNG_STREAMS; k++)
+			m_random[k].reseed(seed, k);
+	}
+
+	std::uint64_t randomSeed() const
+	{
+		return m_seed;
+	}
+
+	RandomGenerator& random(int stream)
+	{
+		return m_random[stream];
+	}
+
+	const RandomGenerator& random(int stream) const
+	{
+		return m_random[stream];
+	}
+
+	GameHost* host() const
+	{
+		return m_host;
+	}
+
+	void setHost(GameHost* host)
+	{
+		m_host = host;
+	}
+
+	ReplayRecorder* recorder() const
+	{
+		return m_recorder;
+	}
+
+	void setRecorder(ReplayRecorder* recorder)
+	{
+		m_recorder = recorder;
+	}
+
+  private:
+	GraphObjectRegistry	m_graphObjects;
+	RandomGenerator		m_random[NUM_RNG_STREAMS];
+	std::uint64_t		m_seed;
+	GameHost*			m_host;
+	ReplayRecorder*		m_recorder;
+
+	  // Prevent copying or assigning WorldContexts
+	WorldContext(const WorldContext&) = delete;
+	WorldContext& operator=(const WorldContext&) = delete;
+};
+
+#endif // WORLDCONTEXT_H_
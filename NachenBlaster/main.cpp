@@ -4,6 +4,9 @@
 #include <string>
 #include "GameWorld.h"
 #include "StudentWorld.h"
+#include "Replay.h"
+#include "AssetPack.h"
+#include <cstdlib>
 using namespace std;
 
   // If your program is having trouble finding the Assets directory,
@@ -23,17 +26,67 @@ int main(int argc, char* argv[])
 		string path = assetDirectory;
 		if (!path.empty())
 			path += '/';
+		  // Either the asset pack or the loose files will do
 		const string someAsset = "ship.tga";
+		ifstream pack(path + ASSET_PACK_FILE);
 		ifstream ifs(path + someAsset);
-		if (!ifs)
+		if (!pack  &&  !ifs)
 		{
-			cout << "Cannot find " << someAsset << " in ";
+			cout << "Cannot find " << ASSET_PACK_FILE << " or " << someAsset << " in ";
 			cout << (assetDirectory.empty() ? "current directory" : assetDirectory) << endl;
 			return 1;
 		}
 	}
 
+	  // --seed S plays the game seeded with S; --record FILE saves it as a
+	  // replay file that NachenBlasterHeadless --replay can play back;
+	  // --tick-ms N moves the game every N ms instead of every 15;
+	  // --sound-file FILE writes the game's sound to a WAV file.  All are
+	  // removed before GLUT sees the arguments.
+
+	string recordPath;
+	string soundPath;
+	bool seeded = false;
+	uint64_t seed = 0;
+	int msPerTick = 0;
+	int newArgc = 1;
+	for (int k = 1; k < argc; k++)
+	{
+		string arg = argv[k];
+		if (arg == "--record"  &&  k+1 < argc)
+			recordPath = argv[++k];
+		else if (arg == "--seed"  &&  k+1 < argc)
+		{
+			seed = strtoull(argv[++k], nullptr, 10);
+			seeded = true;
+		}
+		else if (arg == "--tick-ms"  &&  k+1 < argc)
+			msPerTick = atoi(argv[++k]);
+		else if (arg == "--sound-file"  &&  k+1 < argc)
+			soundPath = argv[++k];
+		else
+			argv[newArgc++] = argv[k];
+	}
+	argv[newArgc] = nullptr;
+
 	GameWorld* gw = createStudentWorld(assetDirectory);
-	Game().run(argc, argv, gw, "NachenBlaster");
+	if (seeded)
+		gw->seedRandom(seed);
+	ReplayRecorder recorder;
+	if (!recordPath.empty())
+	{
+		if (!recorder.open(recordPath, gw->randomSeed(), gw->getLevel(), false))
+		{
+			cout << "Cannot create " << recordPath << endl;
+			return 1;
+		}
+		gw->setRecorder(&recorder);
+	}
+	GameController controller;
+	if (msPerTick > 0)
+		controller.setMsPerTick(msPerTick);
+	if (!soundPath.empty())
+		controller.setAudioOutputFile(soundPath);
+	controller.run(newArgc, argv, gw, "NachenBlaster");
 }
 